@@ -1,6 +1,12 @@
 #include <utility>
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <cmath>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstring>
 #include <cstdio>
 #include <iostream>
 #include "src/main.hxx"
@@ -14,6 +20,10 @@ using namespace std;
 #ifndef TYPE
 #define TYPE float
 #endif
+// You can define number of threads with -DMAX_THREADS=...
+#ifndef MAX_THREADS
+#define MAX_THREADS 64
+#endif
 
 
 
@@ -25,67 +35,472 @@ double getModularity(const G& x, const SlpaResult<K>& a, V M) {
 }
 
 
+template <bool STRICT, class G, class K, class V>
+void runSlpaOmp(const G& x, const vector<K>* init, const SlpaOptions& o, V M, float tseq) {
+  const char *name = STRICT? "slpaOmpStaticStrict" : "slpaOmpStatic      ";
+  int T = min(MAX_THREADS, omp_get_max_threads());
+  for (int t=1; t<=T; t = t<T && 2*t>T? T : 2*t) {
+    omp_set_num_threads(t);
+    auto a = slpaOmpStatic<STRICT>(x, init, o);
+    printf("[%09.3f ms; %04d iters.; %01.9f modularity] %s {labels=%02d, tolerance=%.0e, threads=%02d, speedup=%.2f}\n", a.time, a.iterations, getModularity(x, a, M), name, o.labels, o.tolerance, t, tseq/a.time);
+  }
+  omp_set_num_threads(T);
+}
+
+
+template <bool STRICT, bool PRUNE=false, class G, class K, class V>
+auto runSlpaSeq(const G& x, const vector<K>* init, const SlpaOptions& o, V M) {
+  const char *name = PRUNE? "slpaSeqStaticPrune " : STRICT? "slpaSeqStaticStrict" : "slpaSeqStatic      ";
+  resetPeakResidentMemory();
+  size_t m0 = residentMemory();
+  auto a = slpaSeqStatic<STRICT, PRUNE>(x, init, o);
+  size_t m1 = peakResidentMemory();
+  // Fraction of vertices skipped per iteration, on average.
+  float skipped = a.iterations>1? float(a.skipped) / (x.order() * (a.iterations-1)) : 0;
+  printf("[%09.3f ms; %04d iters.; %01.9f modularity] %s {labels=%02d, tolerance=%.0e, peak=%.3fMB, skipped=%.3f}\n", a.time, a.iterations, getModularity(x, a, M), name, o.labels, o.tolerance, (m1>m0? m1-m0 : 0)/1e6, skipped);
+  return a;
+}
+
+
+template <class G>
+void runPostprocessExperiment(const G& x, int repeat) {
+  using K = typename G::key_type;
+  auto M = edgeWeight(x)/2;
+  auto a = slpaOmpStatic<false>(x, (vector<K>*) nullptr, {1, 0.05f, 100, 0, 16});
+  auto fc = [&](auto u) { return a.membership[u]; };
+  CommunityPostprocess<K> p;
+  double q0 = 0, q1 = 0;
+  float t0 = measureDuration([&]() { q0 = modularityBy(x, fc, M, decltype(M)(1)); }, repeat);
+  float t1 = measureDuration([&]() { q1 = p.template process<false>(x, fc, double(M)); }, repeat);
+  K c1 = p.communities();
+  float t2 = measureDuration([&]() { p.process(x, fc, double(M)); }, repeat);
+  double q2 = p.process(x, fc, double(M));
+  printf("[%09.3f ms; %01.9f modularity] modularityBy\n", t0, q0);
+  printf("[%09.3f ms; %01.9f modularity] communityPostprocess      {split=0, communities=%d, slpa=%.3f}\n", t1, q1, c1, a.time);
+  printf("[%09.3f ms; %01.9f modularity] communityPostprocess      {split=1, communities=%d, slpa=%.3f}\n", t2, q2, p.communities(), a.time);
+}
+
+
 template <class G>
 void runExperiment(const G& x, int repeat) {
   using K = typename G::key_type;
-  using V = typename G::edge_value_type;
   vector<K> *init = nullptr;
   auto M = edgeWeight(x)/2;
   auto Q = modularity(x, M, 1.0f);
   printf("[%01.6f modularity] noop\n", Q);
-  SlpaOptions o = {repeat};
+  float tolerance = 0.05f;
+  for (int labels : {4, 8, 16, 32, 64, 128}) {
+    SlpaOptions o = {repeat, tolerance, 100, 0, labels};
+    // Find SLPA using a single thread.
+    auto ak = runSlpaSeq<false>(x, init, o, M);
+    auto al = runSlpaSeq<true> (x, init, o, M);
+    runSlpaSeq<false, true>(x, init, o, M);
+    // Find SLPA using multiple threads.
+    runSlpaOmp<false>(x, init, o, M, ak.time);
+    runSlpaOmp<true> (x, init, o, M, al.time);
+  }
+}
 
+
+template <class O, class G>
+void runCsrExperiment(const G& x, size_t xmem, int repeat) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  vector<K> *init = nullptr;
+  auto M = edgeWeight(x)/2;
   float tolerance = 0.05f;
-  {
-    // Find SLPA using a single thread (4 labels).
-    auto ak = slpaSeqStatic<4, false>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e}\n", ak.time, ak.iterations, getModularity(x, ak, M), 4, tolerance);
-    auto al = slpaSeqStatic<4, true>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStaticStrict {labels=%02d, tolerance=%.0e}\n", al.time, al.iterations, getModularity(x, al, M), 4, tolerance);
+  // Convert to CSR graph, and measure its footprint.
+  resetPeakResidentMemory();
+  size_t m0 = residentMemory();
+  CsrGraph<K, None, V, O> y;
+  float ty = measureDuration([&]() { y = csrGraphFrom<O>(x); });
+  size_t ymem = residentMemory() - m0;
+  printf("[%09.3f ms] csrGraphFrom {offset=%02d-bit, weighted=%d}\n", ty, int(8*sizeof(O)), y.weighted());
+  printf("[%09.3f MB graph] outDiGraph\n", xmem/1e6);
+  printf("[%09.3f MB graph] csrGraph\n",   ymem/1e6);
+  // Find SLPA on each graph (16 labels), and measure peak memory above baseline.
+  auto runSlpa = [&](const auto& g, const char *format) {
+    resetPeakResidentMemory();
+    size_t m0 = residentMemory();
+    auto a = slpaSeqStatic<false>(g, init, {repeat, tolerance, 100, 0, 16});
+    size_t m1 = peakResidentMemory();
+    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e, format=%s, peak=%.3fMB}\n", a.time, a.iterations, getModularity(g, a, M), 16, tolerance, format, (m1>m0? m1-m0 : 0)/1e6);
+  };
+  runSlpa(x, "outDiGraph");
+  runSlpa(y, "csrGraph");
+}
+
+
+template <class O, class K, class V>
+void runLoadExperiment(const char *file, const char *cache) {
+  // Load graph with memory-mapped parallel reader (symmetricized CSR).
+  CsrGraph<K, None, V, O> y;
+  resetPeakResidentMemory();
+  size_t m0 = residentMemory();
+  bool ok = false;
+  float ty = measureDuration([&]() { ok = readMtxCsrOmpW(y, file, true); });
+  size_t m1 = peakResidentMemory();
+  if (!ok) { fprintf(stderr, "Cannot read graph %s\n", file); return; }
+  print(y); printf(" (readMtxCsrOmp)\n");
+  printf("[%09.3f ms; %09.3f MB peak] readMtxCsrOmp {threads=%02d}\n", ty, (m1>m0? m1-m0 : 0)/1e6, omp_get_max_threads());
+  if (!cache) return;
+  // Reload graph from binary snapshot, or write it if not present.
+  CsrGraph<K, None, V, O> z; bool hit = false;
+  resetPeakResidentMemory();
+  m0 = residentMemory();
+  float tz = measureDuration([&]() { hit = readCsrSnapshotW(z, cache, file); });
+  m1 = peakResidentMemory();
+  if (hit) printf("[%09.3f ms; %09.3f MB peak] readCsrSnapshot {same=%d}\n", tz, (m1>m0? m1-m0 : 0)/1e6, csrEqual(y, z));
+  else {
+    float tw = measureDuration([&]() { hit = writeCsrSnapshot(cache, y, file); });
+    printf("[%09.3f ms] writeCsrSnapshot {ok=%d}\n", tw, hit);
   }
-  {
-    // Find SLPA using a single thread (8 labels).
-    auto ak = slpaSeqStatic<8, false>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e}\n", ak.time, ak.iterations, getModularity(x, ak, M), 8, tolerance);
-    auto al = slpaSeqStatic<8, true>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStaticStrict {labels=%02d, tolerance=%.0e}\n", al.time, al.iterations, getModularity(x, al, M), 8, tolerance);
+}
+
+
+template <class O, class G>
+void runReorderExperiment(const G& x, int repeat) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  vector<K> *init = nullptr;
+  auto M = edgeWeight(x)/2;
+  float tolerance = 0.05f;
+  SlpaOptions o = {repeat, tolerance, 100, 0, 16};
+  // Find SLPA on original vertex ids (CSR), as the baseline.
+  auto y = csrGraphFrom<O>(x);
+  auto a = slpaSeqStatic<false>(y, init, o);
+  printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e, order=none, reorder=%.3f}\n", a.time, a.iterations, getModularity(x, a, M), o.labels, tolerance, 0.0f);
+  // Find SLPA on relabeled graph, and map communities back to original ids.
+  auto runOrder = [&](auto fo, const char *order) {
+    vector<K> ks, ids;
+    CsrGraph<K, None, V, O> z;
+    float tr = measureDuration([&]() {
+      ks  = fo(x);
+      ids = vertexIdsFromOrder(x, ks);
+      z   = csrGraphFromOrder<O>(x, ks, ids);
+    });
+    auto b = slpaSeqStatic<false>(z, init, o);
+    SlpaResult<K> c(membershipFromOrder(x, ks, ids, b.membership), b.iterations, b.time);
+    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e, order=%s, reorder=%.3f}\n", c.time, c.iterations, getModularity(x, c, M), o.labels, tolerance, order, tr);
+  };
+  runOrder([](const auto& x) { return vertexOrderByDegree(x); }, "degree");
+  runOrder([](const auto& x) { return vertexOrderByRcm(x); },    "rcm");
+}
+
+
+template <class G>
+void runKernelExperiment(const G& x, int repeat) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  K S = x.span();
+  K N = x.order();
+  vector<K> vcs;
+  vector<V> vcout(S);
+  vector<K> vcur(S), vnxt(S), vden(S);
+  SlpaMemory<K> vcom(S, SLPA_SLOTS);
+  xorshift32_engine rnd(1);
+  auto fr = [&]() { return rnd(); };
+  auto fa = [](auto u) { return true; };
+  auto fp = [](auto u) {};
+  // Fill label memory with a few iterations, so that vertices speak varied labels.
+  slpaInitialize(vcom, vcur, x);
+  for (int l=0; l<8; ++l) {
+    slpaMoveIteration<false>(vcs, vcout, vnxt, vcom, vcur, x, fr, fa, fp);
+    slpaListenCommunities(vcom, vcur, vnxt, x);
   }
-  {
-    // Find SLPA using a single thread (16 labels).
-    auto ak = slpaSeqStatic<16, false>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e}\n", ak.time, ak.iterations, getModularity(x, ak, M), 16, tolerance);
-    auto al = slpaSeqStatic<16, true>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStaticStrict {labels=%02d, tolerance=%.0e}\n", al.time, al.iterations, getModularity(x, al, M), 16, tolerance);
+  K n = K();
+  x.forEachVertexKey([&](auto u) { if (x.degree(u) <= SLPA_SMALL_DEGREE) ++n; });
+  // Time a single listen step over all vertices (no memory update), with each tally.
+  float td = measureDuration([&]() {
+    rnd = xorshift32_engine(2);
+    x.forEachVertexKey([&](auto u) {
+      slpaClearScan(vcs, vcout);
+      slpaScanCommunities(vcs, vcout, x, u, vcom, fr);
+      vden[u] = slpaChooseCommunity<false>(vcs, vcout);
+    });
+  }, repeat);
+  float ta = measureDuration([&]() {
+    rnd = xorshift32_engine(2);
+    x.forEachVertexKey([&](auto u) { vnxt[u] = slpaScanChooseCommunity<false>(vcs, vcout, x, u, vcom, fr); });
+  }, repeat);
+  printf("[%09.3f ms] slpaScanDense    {small=%.3f}\n", td, float(n)/N);
+  printf("[%09.3f ms] slpaScanAdaptive {small=%.3f, same=%d, speedup=%.2f}\n", ta, float(n)/N, vden==vnxt, td/ta);
+}
+
+
+template <class G>
+void runBatchExperiment(const G& x) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  random_device dev;
+  default_random_engine rnd(dev());
+  int batches = 5;
+  float tolerance = 0.05f;
+  SlpaOptions o = {1, tolerance, 100, 0, 16};
+  for (int e=-7; e<=-1; ++e) {
+    // Batch size is a fraction of undirected edges, with at least one edge.
+    double frac = pow(10.0, e);
+    size_t B = max(size_t(1), size_t(frac * x.size()/2));
+    auto y = duplicate(x);
+    SlpaState<K, V> s(o);
+    s.initialize(y);
+    for (int b=0; b<batches; ++b) {
+      vector<tuple<K, K>> deletions;
+      vector<tuple<K, K, V>> insertions;
+      auto fd = [&](auto u, auto v) { deletions.push_back({u, v}); deletions.push_back({v, u}); };
+      auto fi = [&](auto u, auto v, auto w) {
+        if (u==v || !y.hasVertex(u) || !y.hasVertex(v)) return;
+        insertions.push_back({u, v, w}); insertions.push_back({v, u, w});
+      };
+      for (size_t i=0; i<4*B && deletions.size()<2*B; ++i)
+        removeRandomEdge(y, rnd, fd);
+      for (size_t i=0; i<4*B && insertions.size()<2*B; ++i)
+        addRandomEdge(y, rnd, y.span(), V(1), fi);
+      sort(deletions.begin(), deletions.end());
+      sort(insertions.begin(), insertions.end());
+      deletions.erase(unique(deletions.begin(), deletions.end()), deletions.end());
+      insertions.erase(unique(insertions.begin(), insertions.end()), insertions.end());
+      // Update persistent state (applies batch to graph), and compare with static recompute.
+      auto a = s.update(y, deletions, insertions);
+      auto M = edgeWeight(y)/2;
+      printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaStateUpdate     {labels=%02d, tolerance=%.0e, batch=%.0e}\n", a.time, a.iterations, getModularity(y, a, M), o.labels, tolerance, frac);
+      auto c = slpaSeqStatic<false>(y, (vector<K>*) nullptr, o);
+      printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e, batch=%.0e}\n", c.time, c.iterations, getModularity(y, c, M), o.labels, tolerance, frac);
+    }
+  }
+}
+
+
+// BENCHMARK
+// ---------
+// Run with options (instead of a single graph) to write structured records:
+// ./a.out --graphs a.mtx,b.mtx --labels 8,16 --strict 0,1 --tolerance 0.05
+//         --repeat 5 --variants seq,seqPrune,omp,ompPrune --format csv|json
+//         [--output file] [--counters]
+// Each CSV row is an iteration (of the last repeat) with its run's fields, and
+// each JSON record is a run with an array of iterations. Hardware counters are
+// summed over all threads (for multicore variants), and left empty if unavailable.
+
+struct BenchOptions {
+  vector<string> graphs;
+  vector<int>    labels     = {16};
+  vector<int>    strict     = {0};
+  vector<float>  tolerances = {0.05f};
+  vector<string> variants   = {"seq"};
+  int    repeat   = 1;
+  string format   = "csv";
+  string output;
+  bool   counters = false;
+};
+
+
+inline vector<string> splitOption(const string& x) {
+  vector<string> a;
+  size_t i = 0;
+  while (i <= x.size()) {
+    size_t j = x.find(',', i);
+    if (j == string::npos) j = x.size();
+    if (j > i) a.push_back(x.substr(i, j-i));
+    i = j+1;
+  }
+  return a;
+}
+
+template <class T, class F>
+inline vector<T> splitOptionAs(const string& x, F fn) {
+  vector<T> a;
+  for (const auto& s : splitOption(x))
+    a.push_back(fn(s));
+  return a;
+}
+
+
+BenchOptions parseBenchOptions(int argc, char **argv) {
+  BenchOptions o;
+  for (int i=1; i<argc; ++i) {
+    string k = argv[i];
+    if (k=="--counters") { o.counters = true; continue; }
+    if (i+1 >= argc) { fprintf(stderr, "Missing value for %s\n", k.c_str()); exit(1); }
+    string v = argv[++i];
+    if      (k=="--graphs")    o.graphs     = splitOption(v);
+    else if (k=="--labels")    o.labels     = splitOptionAs<int>(v,   [](const string& s) { return stoi(s); });
+    else if (k=="--strict")    o.strict     = splitOptionAs<int>(v,   [](const string& s) { return stoi(s); });
+    else if (k=="--tolerance") o.tolerances = splitOptionAs<float>(v, [](const string& s) { return stof(s); });
+    else if (k=="--variants")  o.variants   = splitOption(v);
+    else if (k=="--repeat")    o.repeat     = stoi(v);
+    else if (k=="--format")    o.format     = v;
+    else if (k=="--output")    o.output     = v;
+    else { fprintf(stderr, "Unknown option %s\n", k.c_str()); exit(1); }
   }
-  {
-    // Find SLPA using a single thread (32 labels).
-    auto ak = slpaSeqStatic<32, false>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e}\n", ak.time, ak.iterations, getModularity(x, ak, M), 32, tolerance);
-    auto al = slpaSeqStatic<32, true>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStaticStrict {labels=%02d, tolerance=%.0e}\n", al.time, al.iterations, getModularity(x, al, M), 32, tolerance);
+  if (o.format!="csv" && o.format!="json") { fprintf(stderr, "Unknown format %s\n", o.format.c_str()); exit(1); }
+  return o;
+}
+
+
+// Modularity and number of communities, before and after splitting disconnected communities.
+struct BenchQuality {
+  double modularity, splitModularity;
+  size_t communities, splitCommunities;
+  float  time;  // post-processing time (split)
+};
+
+
+// Write a string as a JSON string literal.
+inline void writeJsonString(FILE *f, const char *x) {
+  fputc('"', f);
+  for (; *x; ++x) {
+    unsigned char c = *x;
+    if (c=='"' || c=='\\') fprintf(f, "\\%c", c);
+    else if (c < 0x20) fprintf(f, "\\u%04x", c);
+    else fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+
+template <class K>
+void writeBenchRecord(FILE *f, const BenchOptions& bo, bool& first, const char *graph, float tload, const char *variant, int strict, const SlpaOptions& o, int threads, const SlpaResult<K>& a, const BenchQuality& q, size_t peak) {
+  if (bo.format=="json") {
+    fprintf(f, "%s{\"graph\": ", first? "" : ",\n");
+    writeJsonString(f, graph);
+    fprintf(f, ", \"loadTime\": %.3f, \"variant\": \"%s\", \"strict\": %d, \"labels\": %d, \"tolerance\": %g, \"repeat\": %d, \"threads\": %d, ", tload, variant, strict, o.labels, o.tolerance, o.repeat, threads);
+    fprintf(f, "\"time\": %.3f, \"iterations\": %d, \"peakMemory\": %zu, \"modularity\": %.9f, \"communities\": %zu, ", a.time, a.iterations, peak, q.modularity, q.communities);
+    fprintf(f, "\"splitModularity\": %.9f, \"splitCommunities\": %zu, \"postprocessTime\": %.3f, \"perIteration\": [", q.splitModularity, q.splitCommunities, q.time);
+    for (size_t i=0; i<a.stats.size(); ++i) {
+      const auto& s = a.stats[i];
+      fprintf(f, "%s{\"time\": %.3f, \"changed\": %zu, \"skipped\": %zu", i? ", " : "", s.time, s.changed, s.skipped);
+      for (int c=0; c<PERF_COUNTERS; ++c)
+        if (s.counters.has(c)) fprintf(f, ", \"%s\": %llu", PerfCounters::name(c), (unsigned long long) s.counters.values[c]);
+      fprintf(f, "}");
+    }
+    fprintf(f, "]}");
+  }
+  else {
+    if (first) {
+      fprintf(f, "graph,loadTime,variant,strict,labels,tolerance,repeat,threads,time,iterations,peakMemory,modularity,communities,splitModularity,splitCommunities,postprocessTime,iteration,iterationTime,changed,skipped");
+      for (int c=0; c<PERF_COUNTERS; ++c)
+        fprintf(f, ",%s", PerfCounters::name(c));
+      fprintf(f, "\n");
+    }
+    // A run without iterations still gets a row, with empty iteration fields.
+    for (size_t i=0; i<max(a.stats.size(), size_t(1)); ++i) {
+      fprintf(f, "%s,%.3f,%s,%d,%d,%g,%d,%d,%.3f,%d,%zu,%.9f,%zu,%.9f,%zu,%.3f", graph, tload, variant, strict, o.labels, o.tolerance, o.repeat, threads, a.time, a.iterations, peak, q.modularity, q.communities, q.splitModularity, q.splitCommunities, q.time);
+      if (a.stats.empty()) {
+        fprintf(f, ",,,,");
+        for (int c=0; c<PERF_COUNTERS; ++c)
+          fprintf(f, ",");
+        fprintf(f, "\n");
+        break;
+      }
+      const auto& s = a.stats[i];
+      fprintf(f, ",%zu,%.3f,%zu,%zu", i+1, s.time, s.changed, s.skipped);
+      for (int c=0; c<PERF_COUNTERS; ++c) {
+        if (s.counters.has(c)) fprintf(f, ",%llu", (unsigned long long) s.counters.values[c]);
+        else fprintf(f, ",");
+      }
+      fprintf(f, "\n");
+    }
   }
-  {
-    // Find SLPA using a single thread (64 labels).
-    auto ak = slpaSeqStatic<64, false>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStatic       {labels=%02d, tolerance=%.0e}\n", ak.time, ak.iterations, getModularity(x, ak, M), 64, tolerance);
-    auto al = slpaSeqStatic<64, true>(x, init, {repeat, tolerance});
-    printf("[%09.3f ms; %04d iters.; %01.9f modularity] slpaSeqStaticStrict {labels=%02d, tolerance=%.0e}\n", al.time, al.iterations, getModularity(x, al, M), 64, tolerance);
+  first = false;
+}
+
+
+template <bool STRICT, class G, class K>
+inline SlpaResult<K> runBenchVariant(const G& x, const string& variant, const SlpaOptions& o) {
+  const vector<K> *init = nullptr;
+  if (variant=="seq")      return slpaSeqStatic<STRICT>(x, init, o);
+  if (variant=="seqPrune") return slpaSeqStatic<STRICT, true>(x, init, o);
+  if (variant=="omp")      return slpaOmpStatic<STRICT>(x, init, o);
+  if (variant=="ompPrune") return slpaOmpStatic<STRICT, true>(x, init, o);
+  fprintf(stderr, "Unknown variant %s\n", variant.c_str()); exit(1);
+}
+
+
+int runBenchmark(const BenchOptions& bo) {
+  using K = int;
+  using V = TYPE;
+  FILE *f = bo.output.empty()? stdout : fopen(bo.output.c_str(), "w");
+  if (!f) { fprintf(stderr, "Cannot open %s\n", bo.output.c_str()); return 1; }
+  unique_ptr<PerfCounters> counters(bo.counters? new PerfCounters() : nullptr);
+  if (counters && !counters->available()) fprintf(stderr, "Hardware counters unavailable, skipping them\n");
+  bool first = true;
+  int status = 0;
+  if (bo.format=="json") fprintf(f, "[\n");
+  for (const auto& file : bo.graphs) {
+    CsrGraph<K, None, V> x;
+    bool ok = false;
+    float tload = measureDuration([&]() { ok = readMtxCsrOmpW(x, file.c_str(), true); });
+    auto M = edgeWeight(x)/2;
+    // Skip graphs that cannot be read (or have no edges), and fail at the end.
+    if (!ok || !(M>0)) {
+      fprintf(stderr, "%s graph %s\n", ok? "Skipping edgeless" : "Cannot read", file.c_str());
+      status = 1;
+      continue;
+    }
+    CommunityPostprocess<K> p;
+    for (const auto& variant : bo.variants) {
+      for (int strict : bo.strict) {
+        for (float tolerance : bo.tolerances) {
+          for (int labels : bo.labels) {
+            SlpaOptions o = {bo.repeat, tolerance, 100, 0, labels};
+            o.counters = counters && counters->available()? counters.get() : nullptr;
+            resetPeakResidentMemory();
+            size_t m0 = residentMemory();
+            auto a = strict? runBenchVariant<true, decltype(x), K>(x, variant, o) : runBenchVariant<false, decltype(x), K>(x, variant, o);
+            size_t m1 = peakResidentMemory();
+            int threads = variant.rfind("omp", 0)==0? omp_get_max_threads() : 1;
+            auto fc = [&](auto u) { return a.membership[u]; };
+            BenchQuality q;
+            q.modularity  = p.template process<false>(x, fc, double(M));
+            q.communities = p.communities();
+            q.time = measureDuration([&]() { q.splitModularity = p.process(x, fc, double(M)); });
+            q.splitCommunities = p.communities();
+            writeBenchRecord(f, bo, first, file.c_str(), tload, variant.c_str(), strict, o, threads, a, q, m1>m0? m1-m0 : 0);
+            fflush(f);
+          }
+        }
+      }
+    }
   }
+  if (bo.format=="json") fprintf(f, "\n]\n");
+  if (f != stdout) fclose(f);
+  return status;
 }
 
 
+
+
 int main(int argc, char **argv) {
   using K = int;
   using V = TYPE;
+  if (argc>1 && strncmp(argv[1], "--", 2)==0) return runBenchmark(parseBenchOptions(argc, argv));
   char *file = argv[1];
   int repeat = argc>2? stoi(argv[2]) : 5;
-  OutDiGraph<K, None, V> x;  // V w = 1;
+  char *cache = argc>3? argv[3] : nullptr;
+  OutDiGraph<K, None, V> x, y;  // V w = 1;
   printf("Loading graph %s ...\n", file);
-  readMtxW<true>(x, file); println(x);
-  auto y = symmetricize(x); print(y); printf(" (symmetricize)\n");
+  resetPeakResidentMemory();
+  size_t m0 = residentMemory();
+  float tx = measureDuration([&]() { readMtxW<true>(x, file); });
+  println(x);
+  size_t m1 = residentMemory();
+  float ty = measureDuration([&]() { y = symmetricize(x); });
+  size_t m2 = residentMemory();
+  size_t mp = peakResidentMemory();
+  print(y); printf(" (symmetricize)\n");
+  printf("[%09.3f ms; %09.3f MB peak] readMtxW+symmetricize\n", tx+ty, (mp>m0? mp-m0 : 0)/1e6);
+  if (y.size() < size_t(UINT32_MAX)) runLoadExperiment<uint32_t, K, V>(file, cache);
+  else runLoadExperiment<size_t, K, V>(file, cache);
   // auto fl = [](auto u) { return true; };
   // selfLoopU(y, w, fl); print(y); printf(" (selfLoopAllVertices)\n");
+  runKernelExperiment(y, repeat);
+  runPostprocessExperiment(y, repeat);
   runExperiment(y, repeat);
+  if (y.size() < size_t(UINT32_MAX)) runCsrExperiment<uint32_t>(y, m2-m1, repeat);
+  else runCsrExperiment<size_t>(y, m2-m1, repeat);
+  if (y.size() < size_t(UINT32_MAX)) runReorderExperiment<uint32_t>(y, repeat);
+  else runReorderExperiment<size_t>(y, repeat);
+  runBatchExperiment(y);
   printf("\n");
   return 0;
 }
@@ -5,7 +5,7 @@ const path = require('path');
 const RGRAPH = /^Loading graph .*\/(.*?)\.mtx \.\.\./m;
 const RORDER = /^order: (\d+) size: (\d+) (?:\[\w+\] )?\{\} \(symmetricize\)/m;
 const RORGNL = /^\[(\S+?) modularity\] noop/;
-const RRESLT = /^\[(\S+?) ms; (\d+) iters\.; (\S+?) modularity\] (\w+)(?:\s+\{labels=(\d+), tolerance=(\S+?)\})?/m;
+const RRESLT = /^\[(\S+?) ms; (\d+) iters\.; (\S+?) modularity\] (\w+)(?:\s+\{(.*?)\})?/m;
 
 
 
@@ -43,6 +43,16 @@ function writeCsv(pth, rows) {
 // *-LOG
 // -----
 
+function readAttributes(txt) {
+  var a = {labels: 0, tolerance: 0, threads: 1, speedup: 1, format: 'outDiGraph', peak: 0, batch: 0, order: 'none', reorder: 0, skipped: 0};
+  for (var kv of (txt || '').split(/,\s*/)) {
+    var [k, v] = kv.split('=');
+    if (!k || v==null) continue;
+    a[k] = isNaN(parseFloat(v))? v : parseFloat(v);
+  }
+  return a;
+}
+
 function readLogLine(ln, data, state) {
   if (RGRAPH.test(ln)) {
     var [, graph] = RGRAPH.exec(ln);
@@ -61,20 +71,16 @@ function readLogLine(ln, data, state) {
       iterations:  0,
       modularity:  parseFloat(modularity),
       technique:   'noop',
-      labels:      0,
-      tolerance:   0,
-    }));
+    }, readAttributes('')));
   }
   else if (RRESLT.test(ln)) {
-    var [, time, iterations, modularity, technique, labels, tolerance] = RRESLT.exec(ln);
+    var [, time, iterations, modularity, technique, attributes] = RRESLT.exec(ln);
     data.get(state.graph).push(Object.assign({}, state, {
       time:        parseFloat(time),
       iterations:  parseFloat(iterations),
       modularity:  parseFloat(modularity),
       technique,
-      labels:      parseFloat(labels),
-      tolerance:   parseFloat(tolerance),
-    }));
+    }, readAttributes(attributes)));
   }
   return state;
 }
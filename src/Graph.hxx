@@ -1,5 +1,6 @@
 #pragma once
 #include <utility>
+#include <algorithm>
 #include <vector>
 #include <ostream>
 #include <iostream>
@@ -7,6 +8,8 @@
 
 using std::pair;
 using std::vector;
+using std::count;
+using std::move;
 using std::ostream;
 using std::cout;
 
@@ -756,6 +759,123 @@ using ROrderedGraph  = Graph<K, V, E, ROrderedBitset>;
 
 
 
+// CSR-GRAPH
+// ---------
+// Immutable directed graph stored in compressed sparse row (CSR) format.
+// Edge keys (and edge values, if not all 1) of all vertices are stored
+// contiguously, and are located with an offsets array of type O.
+
+template <class K=int, class V=NONE, class E=NONE, class O=size_t>
+class CsrGraph {
+  // Data.
+  protected:
+  size_t N = 0, M = 0;
+  vector<bool> vexists;
+  vector<V>    vvalues;
+  vector<O>    offsets;
+  vector<K>    ekeys;
+  vector<E>    evalues;     // empty => all edge values are 1
+
+  // Types.
+  public:
+  GRAPH_TYPES(K, V, E)
+  using offset_type = O;
+
+
+  // Property operations.
+  public:
+  GRAPH_SIZES(K, V, E, N, M, vexists)
+  GRAPH_DIRECTEDNESS(K, V, E, true)
+  inline bool weighted() const noexcept { return !evalues.empty(); }
+
+
+  // Scan operations.
+  public:
+  GRAPH_CVERTICES(K, V, E, vexists, vvalues)
+  inline auto cedgeKeys(const K& u) const noexcept {
+    return u<span()? sliceIterable(ekeys, offsets[u], offsets[u+1]) : sliceIterable(ekeys, 0, 0);
+  }
+  inline auto cedgeValues(const K& u) const noexcept {
+    O i = u<span()? offsets[u] : O(), I = u<span()? offsets[u+1] : O();
+    auto fv = [this](size_t j) { return evalues.empty()? E(1) : evalues[j]; };
+    return transformIterable(rangeIterable(size_t(i), size_t(I)), fv);
+  }
+  inline auto cedges(const K& u) const noexcept {
+    return pairIterable(cedgeKeys(u), cedgeValues(u));
+  }
+  GRAPH_VERTICES(K, V, E)
+  GRAPH_EDGES(K, V, E)
+
+  public:
+  GRAPH_CFOREACH_VERTEX(K, V, E, vexists, vvalues)
+  template <class F>
+  inline void cforEachEdgeKey(const K& u, F fn) const noexcept {
+    if (u >= span()) return;
+    for (O i=offsets[u], I=offsets[u+1]; i<I; ++i)
+      fn(ekeys[i]);
+  }
+  template <class F>
+  inline void cforEachEdgeValue(const K& u, F fn) const noexcept {
+    if (u >= span()) return;
+    if (evalues.empty()) { for (O i=offsets[u], I=offsets[u+1]; i<I; ++i) fn(E(1)); }
+    else { for (O i=offsets[u], I=offsets[u+1]; i<I; ++i) fn(evalues[i]); }
+  }
+  template <class F>
+  inline void cforEachEdge(const K& u, F fn) const noexcept {
+    if (u >= span()) return;
+    if (evalues.empty()) { for (O i=offsets[u], I=offsets[u+1]; i<I; ++i) fn(ekeys[i], E(1)); }
+    else { for (O i=offsets[u], I=offsets[u+1]; i<I; ++i) fn(ekeys[i], evalues[i]); }
+  }
+  GRAPH_FOREACH_VERTEX(K, V, E)
+  GRAPH_FOREACH_EDGE(K, V, E)
+
+
+  // Access operations.
+  public:
+  GRAPH_BASE(K, V, E)
+  GRAPH_VERTEX_VALUE(K, V, E, vvalues)
+  inline bool hasVertex(const K& u) const noexcept {
+    return u < span() && vexists[u];
+  }
+  inline bool hasEdge(const K& u, const K& v) const noexcept {
+    bool a = false;
+    cforEachEdgeKey(u, [&](auto w) { a |= w==v; });
+    return a;
+  }
+  inline K degree(const K& u) const noexcept {
+    return u < span()? K(offsets[u+1] - offsets[u]) : 0;
+  }
+  inline E edgeValue(const K& u, const K& v) const noexcept {
+    E a = E();
+    cforEachEdge(u, [&](auto w, auto d) { if (w==v) a = d; });
+    return a;
+  }
+  inline const vector<bool>& csrVertexExists() const noexcept { return vexists; }
+  inline const vector<O>& csrOffsets()   const noexcept { return offsets; }
+  inline const vector<K>& csrEdgeKeys()  const noexcept { return ekeys; }
+  inline const vector<E>& csrEdgeValues() const noexcept { return evalues; }
+
+
+  // Lifetime operations.
+  public:
+  CsrGraph() {}
+  /**
+   * Create a CSR graph from its arrays.
+   * @param vexists does each vertex exist?
+   * @param vvalues vertex value of each vertex
+   * @param offsets offset of edges of each vertex (size: span+1)
+   * @param ekeys edge keys of all vertices
+   * @param evalues edge values of all vertices (empty => all 1)
+   */
+  CsrGraph(vector<bool>&& vexists, vector<V>&& vvalues, vector<O>&& offsets, vector<K>&& ekeys, vector<E>&& evalues) :
+  vexists(move(vexists)), vvalues(move(vvalues)), offsets(move(offsets)), ekeys(move(ekeys)), evalues(move(evalues)) {
+    N = count(this->vexists.begin(), this->vexists.end(), true);
+    M = this->ekeys.size();
+  }
+};
+
+
+
 // GRAPH-VIEW
 // ----------
 
@@ -942,4 +1062,8 @@ GRAPH_WRITE(K, V, E, Bitset, DiGraph)
 GRAPH_WRITE(K, V, E, Bitset, OutDiGraph)
 GRAPH_WRITE(K, V, E, Bitset, Graph)
 GRAPH_WRITE_VIEW(G, GraphView)
+template <class K, class V, class E, class O>
+inline void write(ostream& a, const CsrGraph<K, V, E, O>& x, bool det=false) { writeGraph(a, x, det); }
+template <class K, class V, class E, class O>
+inline ostream& operator<<(ostream& a, const CsrGraph<K, V, E, O>& x) { write(a, x); return a; }
 GRAPH_WRITE_VIEW(G, TransposedGraphView)
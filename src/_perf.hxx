@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+
+
+// PERF-COUNTERS
+// -------------
+// Hardware counters of the calling thread (user-space only), using the
+// Linux perf_event interface. Multicore code opens one on each thread, and
+// adds up their samples. Counters that cannot be opened (no PMU in
+// a VM/container, restrictive perf_event_paranoid, or other platforms)
+// are simply marked unavailable, so that callers can carry on without.
+
+#define PERF_COUNTERS 4
+
+
+struct PerfSample {
+  uint64_t values[PERF_COUNTERS];
+  unsigned valid;  // bitmask of available counters
+
+  inline bool has(int i) const noexcept { return valid & (1u << i); }
+};
+
+
+/**
+ * Add counts of a sample to another (of a different thread), keeping only
+ * counters available in both.
+ * @param a sample to add to (updated)
+ * @param x sample to add
+ */
+inline void addPerfSample(PerfSample& a, const PerfSample& x) noexcept {
+  for (int i=0; i<PERF_COUNTERS; ++i)
+    a.values[i] += x.values[i];
+  a.valid &= x.valid;
+}
+
+
+class PerfCounters {
+  // Data.
+  protected:
+  int fds[PERF_COUNTERS];
+  uint64_t base[PERF_COUNTERS];
+
+
+  // Access operations.
+  public:
+  /**
+   * Get name of a counter.
+   * @param i counter index
+   * @returns counter name
+   */
+  static inline const char* name(int i) noexcept {
+    static const char *names[PERF_COUNTERS] = {"cycles", "instructions", "cacheMisses", "branchMisses"};
+    return names[i];
+  }
+
+  inline bool available(int i) const noexcept { return fds[i] >= 0; }
+  inline bool available() const noexcept {
+    for (int i=0; i<PERF_COUNTERS; ++i)
+      if (available(i)) return true;
+    return false;
+  }
+
+
+  // Update operations.
+  public:
+  /**
+   * Start counting (remember current values).
+   */
+  inline void start() noexcept {
+    for (int i=0; i<PERF_COUNTERS; ++i)
+      base[i] = readCounter(i);
+  }
+
+  /**
+   * Stop counting.
+   * @returns counts since start()
+   */
+  inline PerfSample stop() const noexcept {
+    PerfSample a = {};
+    for (int i=0; i<PERF_COUNTERS; ++i) {
+      if (!available(i)) continue;
+      a.values[i] = readCounter(i) - base[i];
+      a.valid |= 1u << i;
+    }
+    return a;
+  }
+
+
+  // Lifetime operations.
+  public:
+  PerfCounters() {
+#ifdef __linux__
+    static const uint64_t configs[PERF_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i=0; i<PERF_COUNTERS; ++i) {
+      perf_event_attr pe;
+      memset(&pe, 0, sizeof(pe));
+      pe.type   = PERF_TYPE_HARDWARE;
+      pe.size   = sizeof(pe);
+      pe.config = configs[i];
+      pe.exclude_kernel = 1;
+      pe.exclude_hv     = 1;
+      fds[i] = int(syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0));
+      base[i] = 0;
+    }
+#else
+    for (int i=0; i<PERF_COUNTERS; ++i) { fds[i] = -1; base[i] = 0; }
+#endif
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int i=0; i<PERF_COUNTERS; ++i)
+      if (fds[i] >= 0) close(fds[i]);
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+
+  // Helper operations.
+  protected:
+  inline uint64_t readCounter(int i) const noexcept {
+    uint64_t a = 0;
+#ifdef __linux__
+    if (fds[i] >= 0 && read(fds[i], &a, sizeof(a)) != ssize_t(sizeof(a))) a = 0;
+#endif
+    return a;
+  }
+};
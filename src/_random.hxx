@@ -22,3 +22,16 @@ class xorshift32_engine {
 };
 // - https://stackoverflow.com/a/71523041/1413259
 // - https://www.jstatsoft.org/article/download/v008i14/916
+
+
+
+
+// Mix a seed with a pair of keys into a non-zero 32-bit state.
+// Based on the splitmix/murmur3 finalizer.
+inline uint32_t mixSeed32(uint32_t seed, uint32_t i, uint32_t j) {
+  uint32_t x = seed ^ (i * 0x9E3779B9u) ^ (j * 0x85EBCA6Bu);
+  x ^= x >> 16; x *= 0x7FEB352Du;
+  x ^= x >> 15; x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x? x : 0x6D2B79F5u;
+}
@@ -1,4 +1,10 @@
 #pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include <utility>
 #include <chrono>
 #include "_debug.hxx"
@@ -67,6 +73,59 @@ float measureDurationMarked(F fn, int N=1) {
 
 
 
+// MEASURE-MEMORY
+// --------------
+// Uses /proc on Linux, and returns 0 elsewhere.
+
+inline size_t readProcStatusKiB(const char *key) {
+  size_t a = 0;
+  FILE *f = fopen("/proc/self/status", "r");
+  if (!f) return 0;
+  char ln[256];
+  size_t K = strlen(key);
+  while (fgets(ln, sizeof(ln), f)) {
+    if (strncmp(ln, key, K)!=0 || ln[K]!=':') continue;
+    a = strtoull(ln+K+1, nullptr, 10);
+    break;
+  }
+  fclose(f);
+  return a;
+}
+
+/**
+ * Get resident set size of this process.
+ * @returns resident memory in bytes (0 if unavailable)
+ */
+inline size_t residentMemory() {
+  return readProcStatusKiB("VmRSS") * 1024;
+}
+
+/**
+ * Get peak resident set size of this process.
+ * @returns peak resident memory in bytes (0 if unavailable)
+ */
+inline size_t peakResidentMemory() {
+  return readProcStatusKiB("VmHWM") * 1024;
+}
+
+/**
+ * Reset peak resident set size of this process to its current value.
+ * Free heap memory is released to the OS first (with glibc).
+ * @returns whether peak could be reset
+ */
+inline bool resetPeakResidentMemory() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  FILE *f = fopen("/proc/self/clear_refs", "w");
+  if (!f) return false;
+  bool a = fputs("5", f) >= 0;
+  return (fclose(f)==0) && a;
+}
+
+
+
+
 // RETRY
 // -----
 
@@ -1,13 +1,17 @@
 #pragma once
 #include <numeric>
+#include <utility>
 #include <algorithm>
 #include <vector>
 #include "_main.hxx"
 
+using std::pair;
 using std::vector;
+using std::sort;
 using std::iota;
 using std::equal;
 using std::transform;
+using std::move;
 
 
 
@@ -74,59 +78,73 @@ inline auto destinationIndices(const G& x) {
 
 // CSR-EQUAL
 // ---------
+// Offsets (O) may be of a different type than keys (K).
 
-template <class K, class V>
-int csrCompare(const K *xv, const K *xd, const K *xe, const V *xw, const K *yv, const K *yd, const K *ye, const V *yw, K N) {
-  vector<K> ix, iy;
-  for (K u=0; u<N; ++u) {
-    K XOFF = xv[u];
-    K YOFF = yv[u];
-    K XDEG = xd? xd[u] : xv[u+1] - xv[u];
-    K YDEG = yd? yd[u] : yv[u+1] - yv[u];
-    if (XDEG!=YDEG) return sgn(XDEG - YDEG);
-    if (XDEG<=K())  continue;
+template <class O, class K, class V>
+int csrCompare(const O *xv, const K *xd, const K *xe, const V *xw, const O *yv, const K *yd, const K *ye, const V *yw, size_t N) {
+  vector<O> ix, iy;
+  for (size_t u=0; u<N; ++u) {
+    O XOFF = xv[u];
+    O YOFF = yv[u];
+    O XDEG = xd? O(xd[u]) : xv[u+1] - xv[u];
+    O YDEG = yd? O(yd[u]) : yv[u+1] - yv[u];
+    if (XDEG!=YDEG) return XDEG<YDEG? -1 : 1;
+    if (XDEG<=O())  continue;
     ix.resize(XDEG);
     iy.resize(XDEG);
     iota(ix.begin(), ix.end(), XOFF);
     iota(iy.begin(), iy.end(), YOFF);
     sortValues(ix, [&](auto i, auto j) { return xe[i] < xe[j]; });
     sortValues(iy, [&](auto i, auto j) { return ye[i] < ye[j]; });
-    for (K j=K(); j<XDEG; ++j) {
-      if (xe[ix[j]] != ye[iy[j]]) return sgn(xe[ix[j]] - ye[iy[j]]);
+    for (O j=O(); j<XDEG; ++j) {
+      if (xe[ix[j]] != ye[iy[j]]) return xe[ix[j]] < ye[iy[j]]? -1 : 1;
       if (!xw || !yw) continue;
-      if (xw[ix[j]] != yw[iy[j]]) return sgn(xe[ix[j]] - ye[iy[j]]);
+      if (xw[ix[j]] != yw[iy[j]]) return xw[ix[j]] < yw[iy[j]]? -1 : 1;
     }
   }
   return 0;
 }
-template <class K, class V>
-inline int csrCompare(const vector<K>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw, const vector<K>& yv, const vector<K>& yd, const vector<K>& ye, const vector<V>& yw) {
+template <class O, class K, class V>
+inline int csrCompare(const vector<O>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw, const vector<O>& yv, const vector<K>& yd, const vector<K>& ye, const vector<V>& yw) {
   const K *_xd = xd.empty()? nullptr : xd.data();
   const K *_yd = yd.empty()? nullptr : yd.data();
   const V *_xw = xw.empty()? nullptr : xw.data();
   const V *_yw = yw.empty()? nullptr : yw.data();
-  if (xv.size() != yv.size()) return sgn(K(xv.size()) - K(yv.size()));
-  return csrCompare(xv.data(), _xd, xe.data(), _xw, yv.data(), _yd, ye.data(), _yw, K(xv.size()-1));
+  if (xv.size() != yv.size()) return xv.size() < yv.size()? -1 : 1;
+  return csrCompare(xv.data(), _xd, xe.data(), _xw, yv.data(), _yd, ye.data(), _yw, xv.size()-1);
 }
-template <class K>
-inline int csrCompare(const vector<K>& xv, const vector<K>& xe, const vector<K>& yv, const vector<K>& ye) {
+template <class O, class K>
+inline int csrCompare(const vector<O>& xv, const vector<K>& xe, const vector<O>& yv, const vector<K>& ye) {
   vector<K> _;
   return csrCompare(xv, _, xe, _, yv, _, ye, _);
 }
 
-template <class K, class V>
-inline bool csrEqual(const K *xv, const K *xd, const K *xe, const V *xw, const K *yv, const K *yd, const K *ye, const V *yw, size_t N) {
+template <class O, class K, class V>
+inline bool csrEqual(const O *xv, const K *xd, const K *xe, const V *xw, const O *yv, const K *yd, const K *ye, const V *yw, size_t N) {
   return csrCompare(xv, xd, xe, xw, yv, yd, ye, yw, N)==0;
 }
-template <class K, class V>
-inline bool csrEqual(const vector<K>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw, const vector<K>& yv, const vector<K>& yd, const vector<K>& ye, const vector<V>& yw) {
+template <class O, class K, class V>
+inline bool csrEqual(const vector<O>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw, const vector<O>& yv, const vector<K>& yd, const vector<K>& ye, const vector<V>& yw) {
   return csrCompare(xv, xd, xe, xw, yv, yd, ye, yw)==0;
 }
-template <class K>
-inline bool csrEqual(const vector<K>& xv, const vector<K>& xe, const vector<K>& yv, const vector<K>& ye) {
+template <class O, class K>
+inline bool csrEqual(const vector<O>& xv, const vector<K>& xe, const vector<O>& yv, const vector<K>& ye) {
   return csrCompare(xv, xe, yv, ye)==0;
 }
 
+/**
+ * Check if two CSR graphs have the same vertices, edges, and edge values.
+ * @param x a CSR graph
+ * @param y another CSR graph
+ * @returns whether they are equal
+ */
+template <class K, class V, class E, class O>
+inline bool csrEqual(const CsrGraph<K, V, E, O>& x, const CsrGraph<K, V, E, O>& y) {
+  vector<K> _;
+  if (x.csrVertexExists() != y.csrVertexExists() || x.weighted() != y.weighted()) return false;
+  return csrEqual(x.csrOffsets(), _, x.csrEdgeKeys(), x.csrEdgeValues(), y.csrOffsets(), _, y.csrEdgeKeys(), y.csrEdgeValues());
+}
+
 
 
 
@@ -197,3 +215,90 @@ inline V csrSumEdgeValues(const vector<K>& xv, const vector<K>& xd, const vector
   const K *_xd = xd.empty()? nullptr : xd.data();
   return csrSumEdgeValues(xv.data(), _xd, xw.data(), K(xv.size()-1));
 }
+
+
+
+
+// CSR-GRAPH-FROM
+// --------------
+
+/**
+ * Obtain a compact CSR graph from a graph, keeping vertex keys as is.
+ * Edge values are dropped if they are all 1.
+ * @param x original graph
+ * @returns CSR graph with offsets of type O
+ */
+template <class O=size_t, class G>
+auto csrGraphFrom(const G& x) {
+  using K = typename G::key_type;
+  using V = typename G::vertex_value_type;
+  using E = typename G::edge_value_type;
+  K S = x.span();
+  vector<bool> vexists(S);
+  vector<V> vvalues(S);
+  x.forEachVertex([&](auto u, auto d) { vexists[u] = true; vvalues[u] = d; });
+  auto offsets = sourceOffsetsAs(x, rangeIterable(S), O());
+  bool weighted = false;
+  x.forEachVertexKey([&](auto u) {
+    x.forEachEdgeValue(u, [&](auto w) { weighted |= !(w==E(1)); });
+  });
+  vector<K> ekeys(offsets[S]);
+  vector<E> evalues(weighted? offsets[S] : 0);
+  x.forEachVertexKey([&](auto u) {
+    O i = offsets[u];
+    x.forEachEdge(u, [&](auto v, auto w) {
+      if (weighted) evalues[i] = w;
+      ekeys[i++] = v;
+    });
+  });
+  return CsrGraph<K, V, E, O>(move(vexists), move(vvalues), move(offsets), move(ekeys), move(evalues));
+}
+
+
+
+
+// CSR-GRAPH-FROM-ORDER
+// --------------------
+
+/**
+ * Obtain a compact CSR graph from a graph, with vertices relabeled.
+ * Vertex i of the result is vertex ks[i] of the original graph, and
+ * edges of each vertex are sorted by new id.
+ * Edge values are dropped if they are all 1.
+ * @param x original graph
+ * @param ks vertex keys in new order (all vertices)
+ * @param ids new id of each vertex key (ks[i] => i)
+ * @returns CSR graph with offsets of type O, and span |ks|
+ */
+template <class O=size_t, class G, class K>
+auto csrGraphFromOrder(const G& x, const vector<K>& ks, const vector<K>& ids) {
+  using V = typename G::vertex_value_type;
+  using E = typename G::edge_value_type;
+  K S = K(ks.size());
+  vector<bool> vexists(S, true);
+  vector<V> vvalues(S);
+  vector<O> offsets(S+1);
+  for (K i=0; i<S; ++i) {
+    vvalues[i] = x.vertexValue(ks[i]);
+    offsets[i+1] = offsets[i] + x.degree(ks[i]);
+  }
+  bool weighted = false;
+  x.forEachVertexKey([&](auto u) {
+    x.forEachEdgeValue(u, [&](auto w) { weighted |= !(w==E(1)); });
+  });
+  vector<K> ekeys(offsets[S]);
+  vector<E> evalues(weighted? offsets[S] : 0);
+  vector<pair<K, E>> buf;
+  // Read the original graph in its own order, and write edges of each vertex to its new place.
+  x.forEachVertexKey([&](auto u) {
+    O j = offsets[ids[u]];
+    buf.clear();
+    x.forEachEdge(u, [&](auto v, auto w) { buf.push_back({ids[v], w}); });
+    sort(buf.begin(), buf.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [v, w] : buf) {
+      if (weighted) evalues[j] = w;
+      ekeys[j++] = v;
+    }
+  });
+  return CsrGraph<K, V, E, O>(move(vexists), move(vvalues), move(offsets), move(ekeys), move(evalues));
+}
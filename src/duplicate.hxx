@@ -1,4 +1,7 @@
 #pragma once
+#include <vector>
+
+using std::vector;
 
 
 
@@ -40,3 +43,25 @@ inline auto duplicate(const G& x) {
   G a; duplicateW(a, x, true);
   return a;
 }
+
+
+
+
+// DUPLICATE-ORDERED
+// -----------------
+
+template <class H, class G, class K>
+void duplicateOrderedW(H& a, const G& x, const vector<K>& ks, const vector<K>& ids) {
+  for (K u : ks)
+    a.addVertex(ids[u], x.vertexValue(u));
+  for (K u : ks) {
+    x.forEachEdge(u, [&](auto v, auto w) { a.addEdge(ids[u], ids[v], w); });
+  }
+  a.correct(true);
+}
+
+template <class G, class K>
+inline auto duplicateOrdered(const G& x, const vector<K>& ks, const vector<K>& ids) {
+  G a; duplicateOrderedW(a, x, ks, ids);
+  return a;
+}
@@ -3,17 +3,22 @@
 #include "_main.hxx"
 #include "Graph.hxx"
 #include "mtx.hxx"
+#include "snapshot.hxx"
 #include "snap.hxx"
 #include "vertices.hxx"
 #include "edges.hxx"
 #include "csr.hxx"
 #include "duplicate.hxx"
+#include "reorder.hxx"
 #include "transpose.hxx"
 #include "symmetricize.hxx"
 #include "selfLoop.hxx"
 #include "deadEnds.hxx"
 #include "properties.hxx"
 #include "modularity.hxx"
+#include "postprocess.hxx"
 #include "random.hxx"
 #include "slpa.hxx"
 #include "slpaSeq.hxx"
+#include "slpaOmp.hxx"
+#include "slpaState.hxx"
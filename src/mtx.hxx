@@ -1,9 +1,17 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
 #include <string>
 #include <istream>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
 #include "_main.hxx"
 #include "Graph.hxx"
 
@@ -14,6 +22,11 @@ using std::ifstream;
 using std::ofstream;
 using std::getline;
 using std::max;
+using std::sort;
+using std::unique;
+using std::copy;
+using std::move;
+using std::pow;
 
 
 
@@ -97,6 +110,210 @@ READ_MTX_RETURN(Graph, false)
 
 
 
+// READ-MTX-CSR-OMP
+// ----------------
+// Reads a memory-mapped MatrixMarket file directly into a CSR graph,
+// parsing edge lines in parallel chunks (one per thread).
+
+/**
+ * Skip to the start of the next line.
+ * @param p current position
+ * @param e end of text
+ * @returns start of next line (or e)
+ */
+inline const char* mtxNextLine(const char *p, const char *e) {
+  const char *q = (const char*) memchr(p, '\n', e-p);
+  return q? q+1 : e;
+}
+
+
+/**
+ * Parse an unsigned integer, skipping leading blanks.
+ * @param p current position (updated)
+ * @param e end of text
+ * @param a parsed value (updated)
+ * @returns whether a value was parsed
+ */
+inline bool mtxParseUint(const char*& p, const char *e, size_t& a) {
+  while (p<e && (*p==' ' || *p=='\t')) ++p;
+  if (p>=e || *p<'0' || *p>'9') return false;
+  for (a=0; p<e && *p>='0' && *p<='9'; ++p)
+    a = 10*a + (*p-'0');
+  return true;
+}
+
+
+/**
+ * Parse a real number (sign, digits, fraction, exponent), skipping leading blanks.
+ * @param p current position (updated)
+ * @param e end of text
+ * @param a parsed value (updated)
+ * @returns whether a value was parsed
+ */
+inline bool mtxParseReal(const char*& p, const char *e, double& a) {
+  while (p<e && (*p==' ' || *p=='\t')) ++p;
+  bool neg = p<e && *p=='-';
+  if (p<e && (*p=='-' || *p=='+')) ++p;
+  if (p>=e || !((*p>='0' && *p<='9') || *p=='.')) return false;
+  double m = 0, f = 1;
+  for (; p<e && *p>='0' && *p<='9'; ++p)
+    m = 10*m + (*p-'0');
+  if (p<e && *p=='.') {
+    for (++p; p<e && *p>='0' && *p<='9'; ++p)
+      m += (*p-'0') * (f *= 0.1);
+  }
+  if (p<e && (*p=='e' || *p=='E')) {
+    ++p; size_t x = 0;
+    bool xneg = p<e && *p=='-';
+    if (p<e && (*p=='-' || *p=='+')) ++p;
+    mtxParseUint(p, e, x);
+    m *= pow(10.0, xneg? -double(x) : double(x));
+  }
+  a = neg? -m : m;
+  return true;
+}
+
+
+/**
+ * Read a MatrixMarket file into a CSR graph, using multiple threads.
+ * Vertex keys are 1..n, as with readMtxW(). Duplicate edges are merged
+ * (keeping one of their weights), and edge weights are dropped if all 1.
+ * @param a CSR graph (updated only on success)
+ * @param pth path of file
+ * @param symm add reverse of each edge (symmetricize)?
+ * @returns whether file was read (false if it could not be opened/mapped, or is not a coordinate matrix)
+ */
+template <class K, class E, class O>
+bool readMtxCsrOmpW(CsrGraph<K, NONE, E, O>& a, const char *pth, bool symm=false) {
+  using G = CsrGraph<K, NONE, E, O>;
+  int fd = open(pth, O_RDONLY);
+  if (fd<0) return false;
+  struct stat st;
+  if (fstat(fd, &st)<0 || st.st_size==0) { close(fd); return false; }
+  size_t SZ = st.st_size;
+  void *mm  = mmap(nullptr, SZ, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mm==MAP_FAILED) return false;
+  madvise(mm, SZ, MADV_WILLNEED);
+  const char *b = (const char*) mm, *e = b + SZ, *p = b;
+
+  // Read header.
+  string h0, h1, h2, h3, h4;
+  for (; p<e && *p=='%'; p=mtxNextLine(p, e)) {
+    if (e-p<2 || p[1]!='%') continue;
+    stringstream ls(string(p, mtxNextLine(p, e)));
+    ls >> h0 >> h1 >> h2 >> h3 >> h4;
+  }
+  size_t r = 0, c = 0, sz = 0;
+  if (h1!="matrix" || h2!="coordinate" || !mtxParseUint(p, e, r) || !mtxParseUint(p, e, c) || !mtxParseUint(p, e, sz)) {
+    munmap(mm, SZ);
+    return false;
+  }
+  p = mtxNextLine(p, e);
+  bool sym = h4=="symmetric" || h4=="skew-symmetric";
+  bool pat = h3=="pattern";
+  bool rev = symm || sym;
+  size_t S = max(r, c) + 1;
+
+  // Parse edges (in chunks aligned to lines), and count degrees. The number
+  // of chunks is fixed beforehand, so that every chunk is parsed and placed,
+  // however many threads each parallel region actually gets.
+  int C = 4 * omp_get_max_threads();
+  vector<vector<K>> us(C), vs(C);
+  vector<vector<E>> ws(C);
+  vector<O> degrees(S+1);
+  int weighted = 0;
+  #pragma omp parallel for schedule(dynamic, 1) reduction(|:weighted)
+  for (int t=0; t<C; ++t) {
+    const char *cb = t==0? p : mtxNextLine(p + (e-p)*t/C - 1, e);
+    const char *ce = t==C-1? e : mtxNextLine(p + (e-p)*(t+1)/C - 1, e);
+    for (const char *q=cb; q<ce; q=mtxNextLine(q, ce)) {
+      size_t u, v; double w = 1;
+      if (!mtxParseUint(q, ce, u) || !mtxParseUint(q, ce, v)) continue;
+      if (u<1 || v<1 || u>=S || v>=S) continue;
+      if (!pat) mtxParseReal(q, ce, w);
+      weighted |= w!=1;
+      us[t].push_back(K(u)); vs[t].push_back(K(v)); ws[t].push_back(E(w));
+      #pragma omp atomic
+      ++degrees[u];
+      if (!rev) continue;
+      #pragma omp atomic
+      ++degrees[v];
+    }
+  }
+  munmap(mm, SZ);
+
+  // Place edges into CSR slots.
+  vector<O> offsets(S+1);
+  for (size_t u=0; u<S; ++u)
+    offsets[u+1] = offsets[u] + degrees[u];
+  O M = offsets[S];
+  vector<K> ekeys(M);
+  vector<E> evalues(weighted? M : 0);
+  copyValuesOmpW(degrees, offsets);
+  auto fe = [&](K u, K v, E w) {
+    O i;
+    #pragma omp atomic capture
+    i = degrees[u]++;
+    ekeys[i] = v;
+    if (weighted) evalues[i] = w;
+  };
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int t=0; t<C; ++t) {
+    for (size_t i=0, I=us[t].size(); i<I; ++i) {
+      fe(us[t][i], vs[t][i], ws[t][i]);
+      if (rev) fe(vs[t][i], us[t][i], ws[t][i]);
+    }
+    vector<K>().swap(us[t]);
+    vector<K>().swap(vs[t]);
+    vector<E>().swap(ws[t]);
+  }
+
+  // Sort edges of each vertex, and remove duplicates.
+  #pragma omp parallel
+  {
+    vector<pair<K, E>> buf;
+    #pragma omp for schedule(dynamic, 2048)
+    for (size_t u=0; u<S; ++u) {
+      O i = offsets[u], I = offsets[u+1];
+      if (!weighted) {
+        sort(ekeys.begin()+i, ekeys.begin()+I);
+        degrees[u] = unique(ekeys.begin()+i, ekeys.begin()+I) - (ekeys.begin()+i);
+        continue;
+      }
+      buf.clear();
+      for (O j=i; j<I; ++j)
+        buf.push_back({ekeys[j], evalues[j]});
+      sort(buf.begin(), buf.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+      auto be = unique(buf.begin(), buf.end(), [](const auto& x, const auto& y) { return x.first==y.first; });
+      degrees[u] = be - buf.begin();
+      for (O j=0; j<degrees[u]; ++j) {
+        ekeys[i+j]   = buf[j].first;
+        evalues[i+j] = buf[j].second;
+      }
+    }
+  }
+
+  // Compact edges in place (new offsets never exceed old ones).
+  O i = 0;
+  for (size_t u=0; u<S; ++u) {
+    O j = offsets[u], D = degrees[u];
+    offsets[u] = i;
+    copy(ekeys.begin()+j, ekeys.begin()+j+D, ekeys.begin()+i);
+    if (weighted) copy(evalues.begin()+j, evalues.begin()+j+D, evalues.begin()+i);
+    i += D;
+  }
+  offsets[S] = i;
+  ekeys.resize(i); ekeys.shrink_to_fit();
+  evalues.resize(weighted? i : 0); evalues.shrink_to_fit();
+  vector<bool> vexists(S, true);
+  vexists[0] = false;
+  a = G(move(vexists), vector<NONE>(S), move(offsets), move(ekeys), move(evalues));
+  return true;
+}
+
+
+
 // WRITE-MTX
 // ---------
 
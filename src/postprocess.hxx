@@ -0,0 +1,196 @@
+#pragma once
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include "_main.hxx"
+
+using std::vector;
+using std::swap;
+using std::min;
+
+
+
+
+// COMMUNITY-POSTPROCESS
+// ---------------------
+// Post-process community membership of a graph, using multiple threads.
+// A single pass over the edges finds the weight of each vertex, the weight
+// within its community, and (with SPLIT) links vertices of the same community
+// with a concurrent union-find, so that disconnected parts of a community
+// become separate communities. Communities are then renumbered densely, and
+// their sizes and modularity found from the per-vertex weights. Scratch
+// buffers are kept across calls, so that many results of the same graph can
+// be evaluated without allocation.
+
+template <class K, class V=double>
+class CommunityPostprocess {
+  // Data.
+  protected:
+  vector<K> vpar;   // union-find parent / community of each vertex
+  vector<V> vtot;   // total edge weight of each vertex
+  vector<K> vids;   // dense id of each community (by old id)
+  vector<char> vhas;  // is old community id in use?
+  vector<K> bcnt;   // communities found by each thread (then offsets)
+  vector<K> vcom;   // dense community each vertex belongs to
+  vector<K> csiz;   // number of vertices in each community
+  vector<V> ctot;   // total edge weight of each community
+  K ncom = K();     // number of communities
+
+
+  // Access operations.
+  public:
+  /** Get dense community of each vertex (K(-1) for absent vertices). */
+  inline const vector<K>& membership() const noexcept { return vcom; }
+  /** Get number of vertices in each community. */
+  inline const vector<K>& sizes() const noexcept { return csiz; }
+  /** Get total edge weight of each community. */
+  inline const vector<V>& weights() const noexcept { return ctot; }
+  /** Get number of communities. */
+  inline K communities() const noexcept { return ncom; }
+
+
+  // Update operations.
+  public:
+  /**
+   * Split disconnected communities (with SPLIT), renumber them densely, and
+   * find their sizes and modularity.
+   * @param x original graph (symmetric)
+   * @param fc community membership function of each vertex (u), in [0, S)
+   * @param M total weight of "undirected" graph (1/2 of directed graph)
+   * @param R resolution (0, 1]
+   * @returns modularity [-0.5, 1] of resulting communities
+   */
+  template <bool SPLIT=true, class G, class FC>
+  V process(const G& x, FC fc, V M, V R=V(1)) {
+    ASSERT(M>V() && R>V());
+    K S = x.span();
+    resize(S);
+    // Find weight of each vertex, and within its community, and link it to
+    // neighbors in the same community.
+    V ain = V();
+    if (SPLIT) {
+      #pragma omp parallel for schedule(static, 2048)
+      for (K u=0; u<S; ++u)
+        vpar[u] = u;
+    }
+    #pragma omp parallel for schedule(dynamic, 2048) reduction(+:ain)
+    for (K u=0; u<S; ++u) {
+      if (!x.hasVertex(u)) continue;
+      K c = fc(u);
+      V kin = V(), ktot = V();
+      x.forEachEdge(u, [&](auto v, auto w) {
+        ktot += w;
+        if (K(fc(v))!=c) return;
+        kin  += w;
+        if (SPLIT) unite(u, K(v));
+      });
+      vtot[u] = ktot;
+      ain += kin;
+    }
+    // Find (old) community of each vertex, and mark those in use.
+    fillValueOmpU(vhas, char());
+    #pragma omp parallel for schedule(static, 2048)
+    for (K u=0; u<S; ++u) {
+      if (!x.hasVertex(u)) continue;
+      K c = SPLIT? find(u) : K(fc(u));
+      ASSERT(c>=K() && c<S);
+      // Other threads may still be finding roots through vpar[u], and
+      // marking the same community.
+      __atomic_store_n(&vpar[u], c, __ATOMIC_RELAXED);
+      __atomic_store_n(&vhas[c], char(true), __ATOMIC_RELAXED);
+    }
+    // Renumber communities densely (in order of old id).
+    renumber(S);
+    // Find community of each vertex, and size and weight of each community.
+    csiz.assign(ncom, K());
+    ctot.assign(ncom, V());
+    #pragma omp parallel for schedule(static, 2048)
+    for (K u=0; u<S; ++u) {
+      if (!x.hasVertex(u)) { vcom[u] = K(-1); continue; }
+      K c = vids[vpar[u]];
+      vcom[u] = c;
+      #pragma omp atomic
+      csiz[c] += 1;
+      #pragma omp atomic
+      ctot[c] += vtot[u];
+    }
+    V asqr = V();
+    #pragma omp parallel for schedule(static, 2048) reduction(+:asqr)
+    for (K c=0; c<ncom; ++c)
+      asqr += (ctot[c]/(2*M)) * (ctot[c]/(2*M));
+    return ain/(2*M) - R*asqr;
+  }
+
+
+  // Helper operations.
+  protected:
+  inline void resize(K S) {
+    if (K(vcom.size())==S) return;
+    vpar.resize(S);
+    vtot.resize(S);
+    vids.resize(S);
+    vhas.resize(S);
+    vcom.resize(S);
+  }
+
+  /**
+   * Find root of a vertex, halving the path on the way.
+   * @param u vertex
+   * @returns root of u
+   */
+  inline K find(K u) noexcept {
+    while (true) {
+      K p = __atomic_load_n(&vpar[u], __ATOMIC_RELAXED);
+      K g = __atomic_load_n(&vpar[p], __ATOMIC_RELAXED);
+      if (p==g) return p;
+      __atomic_compare_exchange_n(&vpar[u], &p, g, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+      u = g;
+    }
+  }
+
+  /**
+   * Link the roots of two vertices (larger root under smaller).
+   * @param u a vertex
+   * @param v another vertex
+   */
+  inline void unite(K u, K v) noexcept {
+    while (true) {
+      u = find(u);
+      v = find(v);
+      if (u==v) return;
+      if (u<v) swap(u, v);
+      K p = u;
+      if (__atomic_compare_exchange_n(&vpar[u], &p, v, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+    }
+  }
+
+  /**
+   * Assign dense ids to communities in use, with per-thread blocks.
+   * @param S span of graph
+   */
+  inline void renumber(K S) {
+    int T = omp_get_max_threads();
+    bcnt.assign(T+1, K());
+    #pragma omp parallel
+    {
+      int t = omp_get_thread_num();
+      int N = omp_get_num_threads();
+      K i = K(size_t(S) *  t    / N);
+      K I = K(size_t(S) * (t+1) / N);
+      K n = K();
+      for (K c=i; c<I; ++c)
+        if (vhas[c]) ++n;
+      bcnt[t+1] = n;
+      #pragma omp barrier
+      #pragma omp single
+      for (int s=0; s<N; ++s)
+        bcnt[s+1] += bcnt[s];
+      K id = bcnt[t];
+      for (K c=i; c<I; ++c)
+        if (vhas[c]) vids[c] = id++;
+      #pragma omp single
+      ncom = bcnt[N];
+    }
+  }
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include "_main.hxx"
+
+using std::pair;
+using std::vector;
+using std::sort;
+using std::reverse;
+
+
+
+
+// VERTEX-ORDER-BY-DEGREE
+// ----------------------
+// Place high-degree vertices first, so that the labels most often read
+// (by the neighbors of hubs) are packed together.
+
+/**
+ * Obtain vertex keys in descending order of degree.
+ * @param x original graph
+ * @returns vertex keys in new order (ties in ascending key order)
+ */
+template <class G>
+auto vertexOrderByDegree(const G& x) {
+  using K = typename G::key_type;
+  vector<pair<K, K>> dks;
+  x.forEachVertexKey([&](auto u) { dks.push_back({x.degree(u), u}); });
+  sort(dks.begin(), dks.end(), [](const auto& a, const auto& b) {
+    return a.first!=b.first? a.first > b.first : a.second < b.second;
+  });
+  vector<K> a;
+  for (const auto& [d, u] : dks)
+    a.push_back(u);
+  return a;
+}
+
+
+
+
+// VERTEX-ORDER-BY-RCM
+// -------------------
+// Reverse Cuthill-McKee order: breadth-first traversal from a low-degree
+// vertex of each component, visiting neighbors in ascending order of
+// degree, and then reversed. Neighbors end up with nearby ids.
+
+/**
+ * Obtain vertex keys in reverse Cuthill-McKee order.
+ * @param x original graph (symmetric)
+ * @returns vertex keys in new order
+ */
+template <class G>
+auto vertexOrderByRcm(const G& x) {
+  using K = typename G::key_type;
+  K S = x.span();
+  vector<K> a, vs, degs(S);
+  vector<bool> vis(S);
+  a.reserve(x.order());
+  x.forEachVertexKey([&](auto u) { degs[u] = x.degree(u); });
+  // Start each component from the lowest degree vertex not yet visited.
+  auto ds = vertexOrderByDegree(x);
+  for (auto it=ds.rbegin(); it!=ds.rend(); ++it) {
+    K s = *it;
+    if (vis[s]) continue;
+    size_t i = a.size();
+    a.push_back(s); vis[s] = true;
+    for (; i<a.size(); ++i) {
+      K u = a[i];
+      vs.clear();
+      x.forEachEdgeKey(u, [&](auto v) { if (!vis[v]) { vis[v] = true; vs.push_back(v); } });
+      sort(vs.begin(), vs.end(), [&](K p, K q) { return degs[p] < degs[q]; });
+      a.insert(a.end(), vs.begin(), vs.end());
+    }
+  }
+  reverse(a.begin(), a.end());
+  return a;
+}
+
+
+
+
+// VERTEX-IDS-FROM-ORDER
+// ---------------------
+
+/**
+ * Obtain new id of each vertex from an order of vertex keys.
+ * @param x original graph
+ * @param ks vertex keys in new order
+ * @returns new id of each vertex key (ks[i] => i)
+ */
+template <class G, class K>
+auto vertexIdsFromOrder(const G& x, const vector<K>& ks) {
+  vector<K> a(x.span());
+  for (size_t i=0; i<ks.size(); ++i)
+    a[ks[i]] = K(i);
+  return a;
+}
+
+
+
+
+// MEMBERSHIP-FROM-ORDER
+// ---------------------
+
+/**
+ * Map community membership of a reordered graph back to original ids.
+ * @param x original graph
+ * @param ks vertex keys in new order
+ * @param ids new id of each vertex key
+ * @param vcom community each new id belongs to (community ids are new ids)
+ * @returns community each original vertex belongs to (community ids are original keys)
+ */
+template <class G, class K>
+auto membershipFromOrder(const G& x, const vector<K>& ks, const vector<K>& ids, const vector<K>& vcom) {
+  vector<K> a(x.span());
+  x.forEachVertexKey([&](auto u) { a[u] = ks[vcom[ids[u]]]; });
+  return a;
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include <cstdint>
 #include <limits>
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include "_main.hxx"
@@ -8,6 +10,7 @@ using std::pair;
 using std::tuple;
 using std::vector;
 using std::numeric_limits;
+using std::max;
 using std::make_pair;
 using std::move;
 using std::get;
@@ -20,15 +23,21 @@ using std::get;
 
 // Maximum community membership memory per vertex.
 #define SLPA_MEMORY 16
+// Maximum distinct labels remembered per vertex.
+#define SLPA_SLOTS  8
 
 
 struct SlpaOptions {
   int   repeat;
   float tolerance;
   int   maxIterations;
+  uint32_t seed;  // 0 => random, otherwise reproducible (multicore)
+  int   labels;
+  int   slots;
+  PerfCounters *counters = nullptr;  // sampled around each move iteration (multicore opens its own, per thread)
 
-  SlpaOptions(int repeat=1, float tolerance=0.05, int maxIterations=100) :
-  repeat(repeat), tolerance(tolerance), maxIterations(maxIterations) {}
+  SlpaOptions(int repeat=1, float tolerance=0.05, int maxIterations=100, uint32_t seed=0, int labels=SLPA_MEMORY, int slots=SLPA_SLOTS) :
+  repeat(repeat), tolerance(tolerance), maxIterations(maxIterations), seed(seed), labels(labels), slots(slots) {}
 };
 
 
@@ -37,27 +46,174 @@ struct SlpaOptions {
 // SLPA-RESULT
 // -----------
 
+// Measurements of an iteration (of the last repeat).
+struct SlpaIterationStats {
+  float  time;      // move and listen, in milliseconds
+  size_t changed;   // vertices that chose a different label
+  size_t skipped;   // vertices not processed
+  PerfSample counters;  // around move iteration (if enabled)
+};
+
+
 template <class K>
 struct SlpaResult {
   vector<K> membership;
   int   iterations;
   float time;
+  size_t skipped;  // vertices skipped, summed over iterations
+  vector<SlpaIterationStats> stats;
 
-  SlpaResult(vector<K>&& membership, int iterations=0, float time=0) :
-  membership(membership), iterations(iterations), time(time) {}
+  SlpaResult(vector<K>&& membership, int iterations=0, float time=0, size_t skipped=0, vector<SlpaIterationStats>&& stats={}) :
+  membership(membership), iterations(iterations), time(time), skipped(skipped), stats(move(stats)) {}
 
-  SlpaResult(vector<K>& membership, int iterations=0, float time=0) :
-  membership(move(membership)), iterations(iterations), time(time) {}
+  SlpaResult(vector<K>& membership, int iterations=0, float time=0, size_t skipped=0, vector<SlpaIterationStats>&& stats={}) :
+  membership(move(membership)), iterations(iterations), time(time), skipped(skipped), stats(move(stats)) {}
 };
 
 
 
 
-// LABELSET
-// --------
+// SLPA-MEMORY
+// -----------
+// Label memory of each vertex, as a histogram of (label, count) slots.
+// Slots of a vertex are contiguous, and labels/counts are stored as
+// separate arrays. Sum of counts of a vertex is the number of labels it
+// has listened to (including its initial label), and may differ between
+// vertices (the sum is kept per vertex). When all slots are in use, a new
+// label replaces the least frequent one and inherits its count
+// (space-saving), so the most frequent labels are always retained. Counts
+// of a vertex are halved if one of them would overflow.
+
+template <class K, class C=uint16_t>
+class SlpaMemory {
+  // Data.
+  protected:
+  size_t    slots = 0;
+  vector<K> labels;
+  vector<C> counts;
+  vector<uint32_t> totals;  // sum of counts of each vertex
+
+
+  // Access operations.
+  public:
+  inline size_t capacity() const noexcept { return slots; }
+  inline size_t bytes() const noexcept {
+    return labels.size()*sizeof(K) + counts.size()*sizeof(C) + totals.size()*sizeof(uint32_t);
+  }
+
+
+  // Update operations.
+  public:
+  /**
+   * Make a vertex remember only its initial label.
+   * @param u given vertex
+   * @param c initial label
+   */
+  inline void reset(K u, K c) noexcept {
+    size_t i = u*slots;
+    labels[i] = c;
+    counts[i] = C(1);
+    for (size_t j=i+1; j<i+slots; ++j)
+      counts[j] = C();
+    totals[u] = 1;
+  }
+
+
+  /**
+   * Speak a random label from memory of a vertex, based on frequency.
+   * @param u given vertex
+   * @param fr random number generator (32-bit)
+   * @returns spoken label (u itself, if memory is empty)
+   */
+  template <class FR>
+  inline K speak(K u, FR fr) const noexcept {
+    size_t i = u*slots, I = i+slots-1, n = totals[u];
+    ASSERT(n>0);
+    if (!n) return u;
+    // Map random number to [0, n) with multiply-shift, instead of modulo.
+    size_t r = (uint64_t(uint32_t(fr())) * n) >> 32;
+    // Spoken slot is the number of prefix sums <= r (branchless).
+    size_t k = 0, c = 0;
+    for (size_t j=i; j<I; ++j) {
+      c += counts[j];
+      k += c <= r;
+    }
+    return labels[i+k];
+  }
+
+
+  /**
+   * Add a label to memory of a vertex.
+   * @param u given vertex
+   * @param c label listened to
+   */
+  inline void listen(K u, K c) noexcept {
+    size_t i = u*slots, I = i+slots, jmin = i;
+    for (size_t j=i; j<I; ++j) {
+      if (counts[j] && labels[j]==c) { increment(u, j); return; }
+      if (!counts[j]) { labels[j] = c; counts[j] = C(1); ++totals[u]; return; }
+      if (counts[j] < counts[jmin]) jmin = j;
+    }
+    labels[jmin] = c;
+    increment(u, jmin);
+  }
+
+
+  /**
+   * Find the most frequent label in memory of a vertex.
+   * @param u given vertex
+   * @returns most frequent label
+   */
+  inline K best(K u) const noexcept {
+    size_t i = u*slots, I = i+slots, jmax = i;
+    for (size_t j=i+1; j<I; ++j)
+      if (counts[j] > counts[jmax]) jmax = j;
+    return labels[jmax];
+  }
+
+
+  // Lifetime operations.
+  public:
+  SlpaMemory() {}
+  /**
+   * Allocate label memory.
+   * @param S span of graph
+   * @param slots distinct labels remembered per vertex
+   */
+  SlpaMemory(K S, size_t slots) :
+  slots(slots), labels(S*slots), counts(S*slots), totals(S) {}
+
+  /**
+   * Change number of vertices with label memory.
+   * @param S new span of graph
+   */
+  inline void resize(K S) {
+    labels.resize(S*slots);
+    counts.resize(S*slots);
+    totals.resize(S);
+  }
+
 
-template <class K, size_t L>
-using Labelset = array<K, L>;
+  // Helper operations.
+  protected:
+  /**
+   * Increment count of a slot, halving all counts of its vertex on overflow.
+   * @param u given vertex
+   * @param j slot index
+   */
+  inline void increment(K u, size_t j) noexcept {
+    if (counts[j]==numeric_limits<C>::max()) {
+      uint32_t n = 0;
+      for (size_t i=u*slots, I=i+slots; i<I; ++i) {
+        counts[i] = counts[i]? max(C(counts[i]/2), C(1)) : C();
+        n += counts[i];
+      }
+      totals[u] = n;
+    }
+    ++counts[j];
+    ++totals[u];
+  }
+};
 
 
 
@@ -68,23 +224,25 @@ using Labelset = array<K, L>;
 /**
  * Initialize communities such that each vertex is its own community.
  * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
  * @param x original graph
  */
-template <class G, class K, size_t L>
-inline void slpaInitialize(vector<Labelset<K, L>>& vcom, const G& x) {
-  x.forEachVertexKey([&](auto u) { vcom[u] = {u}; });
+template <class G, class K, class C>
+inline void slpaInitialize(SlpaMemory<K, C>& vcom, vector<K>& vcur, const G& x) {
+  x.forEachVertexKey([&](auto u) { vcom.reset(u, u); vcur[u] = u; });
 }
 
 
 /**
  * Initialize communities from given initial communities.
  * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
  * @param x original graph
  * @param q initial community each vertex belongs to
  */
-template <class G, class K, size_t L>
-inline void slpaInitializeFrom(vector<Labelset<K, L>>& vcom, const G& x, const vector<K>& q) {
-  x.forEachVertexKey([&](auto u) { vcom[u] = {q[u]}; });
+template <class G, class K, class C>
+inline void slpaInitializeFrom(SlpaMemory<K, C>& vcom, vector<K>& vcur, const G& x, const vector<K>& q) {
+  x.forEachVertexKey([&](auto u) { vcom.reset(u, q[u]); vcur[u] = q[u]; });
 }
 
 
@@ -119,13 +277,12 @@ inline void slpaScanInitialCommunity(vector<K>& vcs, vector<V>& vcout, K u, K v,
  * @param v outgoing edge vertex
  * @param w outgoing edge weight
  * @param vcom community set each vertex belongs to
- * @param l number of labels available
  * @param fr random number generator
  */
-template <bool SELF=false, class K, class V, size_t L, class FR>
-inline void slpaScanCommunity(vector<K>& vcs, vector<V>& vcout, K u, K v, V w, const vector<Labelset<K, L>>& vcom, K l, FR fr) {
+template <bool SELF=false, class K, class V, class C, class FR>
+inline void slpaScanCommunity(vector<K>& vcs, vector<V>& vcout, K u, K v, V w, const SlpaMemory<K, C>& vcom, FR fr) {
   if (!SELF && u==v) return;
-  K c = vcom[v][fr() % l];
+  K c = vcom.speak(v, fr);
   if (!vcout[c]) vcs.push_back(c);
   vcout[c] += w;
 }
@@ -138,12 +295,11 @@ inline void slpaScanCommunity(vector<K>& vcs, vector<V>& vcout, K u, K v, V w, c
  * @param x original graph
  * @param u given vertex
  * @param vcom community set each vertex belongs to
- * @param l number of labels available
  * @param fr random number generator
  */
-template <bool SELF=false, class G, class K, class V, size_t L, class FR>
-inline void slpaScanCommunities(vector<K>& vcs, vector<V>& vcout, const G& x, K u, const vector<Labelset<K, L>>& vcom, K l, FR fr) {
-  x.forEachEdge(u, [&](auto v, auto w) { slpaScanCommunity<SELF>(vcs, vcout, u, v, w, vcom, l, fr); });
+template <bool SELF=false, class G, class K, class V, class C, class FR>
+inline void slpaScanCommunities(vector<K>& vcs, vector<V>& vcout, const G& x, K u, const SlpaMemory<K, C>& vcom, FR fr) {
+  x.forEachEdge(u, [&](auto v, auto w) { slpaScanCommunity<SELF>(vcs, vcout, u, v, w, vcom, fr); });
 }
 
 
@@ -182,33 +338,97 @@ inline K slpaChooseCommunity(const vector<K>& vcs, const vector<V>& vcout) {
 
 
 
-// SLPA-BEST-COMMUNITIES
-// ---------------------
+// SLPA-SCAN-CHOOSE-COMMUNITY
+// --------------------------
+// Most vertices have a low degree, and scattering their few labels into
+// the span-sized vcout array is mostly cache misses. So, labels spoken to
+// such vertices are tallied in a small local buffer (with linear search),
+// and the dense array is only used for high-degree vertices (hubs).
 
-template <class K, size_t L>
-inline void slpaSortCommunities(vector<Labelset<K, L>>& vcom, K l) {
-  K S = vcom.size();
-  vector<K> a(S);
-  for (K u=0; u<S; ++u) {
-    auto ib = vcom[u].begin();
-    auto ie = vcom[u].begin() + l;
-    sort_values(ib, ie);
+// Maximum degree of a vertex for using a small local tally.
+#define SLPA_SMALL_DEGREE 32
+
+
+/**
+ * Choose community with most weight spoken to a low-degree vertex.
+ * @param x original graph
+ * @param u given vertex (degree <= SLPA_SMALL_DEGREE)
+ * @param vcom community set each vertex belongs to
+ * @param fr random number generator
+ * @returns best community
+ */
+template <bool STRICT=false, bool SELF=false, class G, class K, class C, class FR>
+inline K slpaChooseCommunitySmall(const G& x, K u, const SlpaMemory<K, C>& vcom, FR fr) {
+  using V = typename G::edge_value_type;
+  K cs[SLPA_SMALL_DEGREE];
+  V ws[SLPA_SMALL_DEGREE];
+  int n = 0;
+  x.forEachEdge(u, [&](auto v, auto w) {
+    if (!SELF && u==v) return;
+    K c = vcom.speak(v, fr);
+    int i = n;
+    for (int j=0; j<n; ++j)
+      i = cs[j]==c? j : i;
+    if (i==n) { cs[n] = c; ws[n++] = w; }
+    else ws[i] += w;
+  });
+  K cmax = K();
+  V wmax = V();
+  for (int i=0; i<n; ++i) {
+    // Same tie-breaking as slpaChooseCommunity().
+    if (ws[i]>wmax || (!STRICT && ws[i]==wmax && (cs[i] & 2))) { cmax = cs[i]; wmax = ws[i]; }
   }
+  return cmax;
 }
 
 
-template <class K, size_t L>
-inline K slpaBestCommunity(const Labelset<K, L>& labs, K l) {
-  return most_frequent(labs.begin(), labs.begin()+l);
+/**
+ * Scan communities connected to a vertex, and choose the one with most weight.
+ * @param vcs communities vertex u is linked to (scratch)
+ * @param vcout total edge weight from vertex u to community C (scratch)
+ * @param x original graph
+ * @param u given vertex
+ * @param vcom community set each vertex belongs to
+ * @param fr random number generator
+ * @returns best community
+ */
+template <bool STRICT=false, bool SELF=false, class G, class K, class V, class C, class FR>
+inline K slpaScanChooseCommunity(vector<K>& vcs, vector<V>& vcout, const G& x, K u, const SlpaMemory<K, C>& vcom, FR fr) {
+  if (x.degree(u) <= SLPA_SMALL_DEGREE) return slpaChooseCommunitySmall<STRICT, SELF>(x, u, vcom, fr);
+  slpaClearScan(vcs, vcout);
+  slpaScanCommunities<SELF>(vcs, vcout, x, u, vcom, fr);
+  return slpaChooseCommunity<STRICT>(vcs, vcout);
 }
 
 
-template <class K, size_t L>
-inline vector<K> slpaBestCommunities(const vector<Labelset<K, L>>& vcom, K l) {
-  K S = vcom.size();
+
+
+// SLPA-LISTEN-COMMUNITIES
+// -----------------------
+
+/**
+ * Add community chosen by each vertex in this iteration to its memory.
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param vnxt community chosen by each vertex in this iteration
+ * @param x original graph
+ */
+template <class G, class K, class C>
+inline void slpaListenCommunities(SlpaMemory<K, C>& vcom, vector<K>& vcur, const vector<K>& vnxt, const G& x) {
+  x.forEachVertexKey([&](auto u) { vcom.listen(u, vnxt[u]); vcur[u] = vnxt[u]; });
+}
+
+
+
+
+// SLPA-BEST-COMMUNITIES
+// ---------------------
+
+template <class K, class C>
+inline vector<K> slpaBestCommunities(const SlpaMemory<K, C>& vcom, K S) {
   vector<K> a(S);
   for (K u=0; u<S; ++u)
-    a[u] = slpaBestCommunity(vcom[u], l);
+    a[u] = vcom.best(u);
   return a;
 }
 
@@ -232,12 +452,11 @@ inline vector<K> slpaBestCommunities(const vector<Labelset<K, L>>& vcom, K l) {
  * @param q community each vertex belongs to
  * @returns flags for each vertex marking whether it is affected
  */
-template <bool STRICT=false, class FLAG=bool, class G, class K, class V, size_t L, class FR>
+template <bool STRICT=false, class FLAG=bool, class G, class K, class V>
 auto slpaAffectedVerticesDeltaScreening(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& q) {
   K S = x.span();
   vector<K> vcs; vector<V> vcout(S);
   vector<FLAG> vertices(S), neighbors(S), communities(S);
-  auto fr = []() { return 0; };
   for (const auto& [u, v] : deletions) {
     if (q[u]!=q[v]) continue;
     vertices[u]  = true;
@@ -287,7 +506,7 @@ auto slpaAffectedVerticesDeltaScreening(const G& x, const vector<tuple<K, K>>& d
  * @param q community each vertex belongs to
  * @returns flags for each vertex marking whether it is affected
  */
-template <class FLAG=bool, class G, class K, class V, size_t L, class FR>
+template <class FLAG=bool, class G, class K, class V>
 auto slpaAffectedVerticesFrontier(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& q) {
   K S = x.span();
   vector<FLAG> vertices(S);
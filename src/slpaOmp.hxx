@@ -0,0 +1,387 @@
+#pragma once
+#include <utility>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <omp.h>
+#include "_main.hxx"
+#include "vertices.hxx"
+#include "edges.hxx"
+#include "csr.hxx"
+#include "slpa.hxx"
+
+using std::pair;
+using std::tuple;
+using std::vector;
+using std::random_device;
+using std::make_pair;
+using std::swap;
+using std::min;
+using std::max;
+
+
+
+
+// SLPA-HASHTABLES
+// ---------------
+
+/**
+ * Allocate per-thread communities scan data (on the thread that uses it).
+ * @param vcs communities vertex u is linked to (updated)
+ * @param vcout total edge weight from vertex u to community C (updated)
+ * @param S span of graph
+ */
+template <class K, class V>
+inline void slpaAllocateHashtablesW(vector<vector<K>*>& vcs, vector<vector<V>*>& vcout, K S) {
+  int T = vcs.size();
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<T; ++t) {
+    vcs[t]   = new vector<K>();
+    vcout[t] = new vector<V>(S);
+  }
+}
+
+
+/**
+ * Free per-thread communities scan data.
+ * @param vcs communities vertex u is linked to (updated)
+ * @param vcout total edge weight from vertex u to community C (updated)
+ */
+template <class K, class V>
+inline void slpaFreeHashtablesW(vector<vector<K>*>& vcs, vector<vector<V>*>& vcout) {
+  int T = vcs.size();
+  for (int t=0; t<T; ++t) {
+    delete vcs[t];
+    delete vcout[t];
+  }
+}
+
+
+
+
+// SLPA-PERF-COUNTERS
+// ------------------
+
+/**
+ * Open hardware counters on each thread of a team (counters of threads that
+ * are not in the team are left null).
+ * @param ctrs hardware counters, per thread (updated)
+ */
+inline void slpaAllocatePerfCountersW(vector<PerfCounters*>& ctrs) {
+  int T = ctrs.size();
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    if (t<T) ctrs[t] = new PerfCounters();
+  }
+}
+
+
+/**
+ * Close per-thread hardware counters.
+ * @param ctrs hardware counters, per thread (updated)
+ */
+inline void slpaFreePerfCountersW(vector<PerfCounters*>& ctrs) {
+  for (auto *c : ctrs)
+    delete c;
+}
+
+
+/**
+ * Start counting on all threads (from the calling thread).
+ * @param ctrs hardware counters, per thread
+ */
+inline void slpaStartPerfCounters(vector<PerfCounters*>& ctrs) {
+  for (auto *c : ctrs)
+    if (c) c->start();
+}
+
+
+/**
+ * Stop counting on all threads (from the calling thread).
+ * @param ctrs hardware counters, per thread
+ * @returns counts since start, summed over threads (unavailable if any thread lacks counters)
+ */
+inline PerfSample slpaStopPerfCounters(const vector<PerfCounters*>& ctrs) {
+  PerfSample a = {};
+  a.valid = ~0u;
+  for (auto *c : ctrs) {
+    if (c) addPerfSample(a, c->stop());
+    else a.valid = 0;
+  }
+  return a;
+}
+
+
+
+
+// SLPA-INITIALIZE
+// ---------------
+
+/**
+ * Initialize communities such that each vertex is its own community.
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param x original graph
+ */
+template <class G, class K, class C>
+inline void slpaInitializeOmp(SlpaMemory<K, C>& vcom, vector<K>& vcur, const G& x) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    vcom.reset(u, u);
+    vcur[u] = u;
+  }
+}
+
+
+/**
+ * Initialize communities from given initial communities.
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param x original graph
+ * @param q initial community each vertex belongs to
+ */
+template <class G, class K, class C>
+inline void slpaInitializeFromOmp(SlpaMemory<K, C>& vcom, vector<K>& vcur, const G& x, const vector<K>& q) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    vcom.reset(u, q[u]);
+    vcur[u] = q[u];
+  }
+}
+
+
+
+
+// SLPA-MOVE-ITERATION
+// -------------------
+
+/**
+ * Move each vertex to its best community, using multiple threads.
+ * Memory of vertices is only updated after the iteration, so an
+ * iteration behaves the same regardless of vertex order.
+ * Vertices that are not processed (skipped) keep their latest community.
+ * @param vcs communities vertex u is linked to, per thread (updated)
+ * @param vcout total edge weight from vertex u to community C, per thread (updated)
+ * @param vnxt community chosen by each vertex in this iteration (updated)
+ * @param rnds random number generator, per thread (updated)
+ * @param vcom community set each vertex belongs to
+ * @param vcur latest community each vertex listened to
+ * @param x original graph
+ * @param l current iteration
+ * @param seed reproducible seed (0 => use per-thread generators)
+ * @param fa is vertex allowed to be updated? (u)
+ * @param fp process vertices whose communities have changed (u)
+ * @returns number of changed, skipped vertices
+ */
+template <bool STRICT=false, class G, class K, class V, class C, class FA, class FP>
+pair<K, K> slpaMoveIterationOmp(vector<vector<K>*>& vcs, vector<vector<V>*>& vcout, vector<K>& vnxt, vector<xorshift32_engine*>& rnds, const SlpaMemory<K, C>& vcom, const vector<K>& vcur, const G& x, K l, uint32_t seed, FA fa, FP fp) {
+  K a = K(), b = K();
+  K S = x.span();
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:a,b)
+  for (K u=0; u<S; ++u) {
+    int t = omp_get_thread_num();
+    vnxt[u] = vcur[u];
+    if (!x.hasVertex(u)) continue;
+    if (!fa(u)) { ++b; continue; }
+    // With a seed, each (iteration, vertex) pair gets its own stream.
+    xorshift32_engine rnd = seed? xorshift32_engine(mixSeed32(seed, l, u)) : *rnds[t];
+    auto fr = [&]() { return rnd(); };
+    vnxt[u] = slpaScanChooseCommunity<STRICT>(*vcs[t], *vcout[t], x, u, vcom, fr);
+    if (!seed) *rnds[t] = rnd;
+    if (vnxt[u]!=vcur[u]) { ++a; fp(u); }
+  }
+  return make_pair(a, b);
+}
+
+
+
+
+// SLPA-LISTEN-COMMUNITIES
+// -----------------------
+
+/**
+ * Add community chosen by each vertex in this iteration to its memory.
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param vnxt community chosen by each vertex in this iteration
+ * @param x original graph
+ */
+template <class G, class K, class C>
+inline void slpaListenCommunitiesOmp(SlpaMemory<K, C>& vcom, vector<K>& vcur, const vector<K>& vnxt, const G& x) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    vcom.listen(u, vnxt[u]);
+    vcur[u] = vnxt[u];
+  }
+}
+
+
+
+
+// SLPA-BEST-COMMUNITIES
+// ---------------------
+
+template <class K, class C>
+inline vector<K> slpaBestCommunitiesOmp(const SlpaMemory<K, C>& vcom, K S) {
+  vector<K> a(S);
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u)
+    a[u] = vcom.best(u);
+  return a;
+}
+
+
+
+
+// SLPA-LISTEN-COMMUNITIES-PRUNE
+// -----------------------------
+
+/**
+ * Add community chosen by each vertex in this iteration to its memory, and
+ * find vertices to process in the next iteration (when pruning), using
+ * multiple threads (see slpaListenCommunitiesPrune()).
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param vact is vertex active? (updated)
+ * @param vnew scratch flags (updated)
+ * @param vbst community each vertex belongs to (updated)
+ * @param vnxt community chosen by each vertex in this iteration
+ * @param x original graph
+ */
+template <class G, class K, class C>
+inline void slpaListenCommunitiesPruneOmp(SlpaMemory<K, C>& vcom, vector<K>& vcur, vector<char>& vact, vector<char>& vnew, vector<K>& vbst, const vector<K>& vnxt, const G& x) {
+  K S = x.span();
+  fillValueOmpU(vnew, char());
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u) || !vact[u]) continue;
+    vcom.listen(u, vnxt[u]);
+    vcur[u] = vnxt[u];
+    K c = vcom.best(u);
+    // Flags of next active set are set by several threads, so store them atomically.
+    if (c!=vcur[u]) __atomic_store_n(&vnew[u], char(true), __ATOMIC_RELAXED);
+    if (c==vbst[u]) continue;
+    vbst[u] = c;
+    x.forEachEdgeKey(u, [&](auto v) { __atomic_store_n(&vnew[v], char(true), __ATOMIC_RELAXED); });
+  }
+  swap(vact, vnew);
+}
+
+
+
+
+// SLPA-OMP
+// --------
+
+// With PRUNE, only active vertices are processed in each iteration (see slpaSeq()).
+
+template <bool STRICT=false, bool PRUNE=false, class G, class K, class FA, class FP>
+SlpaResult<K> slpaOmp(const G& x, const vector<K>* q, const SlpaOptions& o, FA fa, FP fp) {
+  using V = typename G::edge_value_type;
+  int l = 0;
+  size_t s = 0;
+  vector<SlpaIterationStats> stats;
+  int T = omp_get_max_threads();
+  K S = x.span();
+  K N = x.order();
+  vector<vector<K>*> vcs(T);
+  vector<vector<V>*> vcout(T);
+  vector<xorshift32_engine*> rnds(T);
+  vector<PerfCounters*> ctrs(o.counters? T : 0);
+  vector<K> vcur(S), vnxt(S);
+  // Flags are char (not bool), so that threads can mark neighbors concurrently.
+  vector<K> vbst(PRUNE? S : 0);
+  vector<char> vact(PRUNE? S : 0), vnew(PRUNE? S : 0);
+  SlpaMemory<K> vcom(S, min(o.slots, o.labels));
+  random_device dev;
+  for (int t=0; t<T; ++t)
+    rnds[t] = new xorshift32_engine(dev());
+  // Span-sized scan buffers are only used by high-degree vertices.
+  bool hubs = false;
+  #pragma omp parallel for schedule(static, 2048) reduction(||:hubs)
+  for (K u=0; u<S; ++u)
+    hubs = hubs || x.degree(u) > SLPA_SMALL_DEGREE;
+  slpaAllocateHashtablesW(vcs, vcout, hubs? S : K());
+  // Counters of each thread are read by the calling thread, around the move iteration.
+  if (o.counters) slpaAllocatePerfCountersW(ctrs);
+  auto fb = [&](auto u) { return fa(u) && (!PRUNE || vact[u]); };
+  float t = measureDuration([&]() {
+    if (q) slpaInitializeFromOmp(vcom, vcur, x, *q);
+    else   slpaInitializeOmp(vcom, vcur, x);
+    if (PRUNE) { fillValueOmpU(vact, char(true)); copyValuesOmpW(vbst, vcur); }
+    stats.clear();
+    for (l=0, s=0; l < min(o.maxIterations, o.labels-1);) {
+      auto t0 = timeNow();
+      slpaStartPerfCounters(ctrs);
+      auto [n, m] = slpaMoveIterationOmp<STRICT>(vcs, vcout, vnxt, rnds, vcom, vcur, x, K(++l), o.seed, fb, fp); s += m;
+      PerfSample c = o.counters? slpaStopPerfCounters(ctrs) : PerfSample();
+      if (PRUNE) slpaListenCommunitiesPruneOmp(vcom, vcur, vact, vnew, vbst, vnxt, x);
+      else slpaListenCommunitiesOmp(vcom, vcur, vnxt, x);
+      stats.push_back({durationMilliseconds(t0, timeNow()), size_t(n), size_t(m), c});
+      PRINTFD("slpaOmp(): l=%d, n=%d, N=%d, n/N=%f, skipped=%d\n", l, n, N, float(n)/N, m);
+      // Converged if few vertices have changed (of the processed ones, when pruning).
+      if (float(n)/(PRUNE? max(N-m, K(1)) : N) <= o.tolerance) break;
+    } ++l;
+  }, o.repeat);
+  slpaFreeHashtablesW(vcs, vcout);
+  slpaFreePerfCountersW(ctrs);
+  for (int t=0; t<T; ++t)
+    delete rnds[t];
+  return {slpaBestCommunitiesOmp(vcom, S), l, t, s, move(stats)};
+}
+template <bool STRICT=false, bool PRUNE=false, class G, class K, class FA>
+inline SlpaResult<K> slpaOmp(const G& x, const vector<K>* q, const SlpaOptions& o, FA fa) {
+  auto fp = [](auto u) {};
+  return slpaOmp<STRICT, PRUNE>(x, q, o, fa, fp);
+}
+template <bool STRICT=false, bool PRUNE=false, class G, class K>
+inline SlpaResult<K> slpaOmp(const G& x, const vector<K>* q, const SlpaOptions& o) {
+  auto fa = [](auto u) { return true; };
+  return slpaOmp<STRICT, PRUNE>(x, q, o, fa);
+}
+
+
+
+
+// SLPA-OMP-STATIC
+// ---------------
+
+template <bool STRICT=false, bool PRUNE=false, class G, class K>
+inline SlpaResult<K> slpaOmpStatic(const G& x, const vector<K>* q=nullptr, const SlpaOptions& o={}) {
+  return slpaOmp<STRICT, PRUNE>(x, q, o);
+}
+
+
+
+
+// SLPA-OMP-DYNAMIC-DELTA-SCREENING
+// --------------------------------
+
+template <bool STRICT=false, class G, class K, class V>
+inline SlpaResult<K> slpaOmpDynamicDeltaScreening(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const SlpaOptions& o={}) {
+  auto vaff = slpaAffectedVerticesDeltaScreening<STRICT, char>(x, deletions, insertions, *q);
+  auto fa   = [&](auto u) { return vaff[u]==true; };
+  return slpaOmp<STRICT>(x, q, o, fa);
+}
+
+
+
+
+// SLPA-OMP-DYNAMIC-FRONTIER
+// -------------------------
+
+template <bool STRICT=false, class G, class K, class V>
+inline SlpaResult<K> slpaOmpDynamicFrontier(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const SlpaOptions& o={}) {
+  // Flags are char (not bool), and accessed atomically, as threads mark neighbors concurrently.
+  auto vaff = slpaAffectedVerticesFrontier<char>(x, deletions, insertions, *q);
+  auto fa = [&](auto u) { return __atomic_load_n(&vaff[u], __ATOMIC_RELAXED)==true; };
+  auto fp = [&](auto u) { x.forEachEdgeKey(u, [&](auto v) { __atomic_store_n(&vaff[v], char(true), __ATOMIC_RELAXED); }); };
+  return slpaOmp<STRICT>(x, q, o, fa, fp);
+}
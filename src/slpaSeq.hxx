@@ -9,12 +9,14 @@
 #include "csr.hxx"
 #include "slpa.hxx"
 
+using std::pair;
 using std::tuple;
 using std::vector;
 using std::random_device;
 using std::make_pair;
 using std::swap;
 using std::min;
+using std::max;
 
 
 
@@ -24,25 +26,65 @@ using std::min;
 
 /**
  * Move each vertex to its best community.
+ * Vertices that are not processed (skipped) keep their latest community.
  * @param vcs communities vertex u is linked to (updated)
  * @param vcout total edge weight from vertex u to community C (updated)
- * @param vcom community set each vertex belongs to (updated)
+ * @param vnxt community chosen by each vertex in this iteration (updated)
+ * @param vcom community set each vertex belongs to
+ * @param vcur latest community each vertex listened to
  * @param x original graph
- * @param l number of labels available
  * @param fr random number generator
- * @returns number of changed vertices
+ * @param fa is vertex allowed to be updated? (u)
+ * @param fp process vertices whose communities have changed (u)
+ * @returns number of changed, skipped vertices
+ */
+template <bool STRICT=false, class G, class K, class V, class C, class FR, class FA, class FP>
+pair<K, K> slpaMoveIteration(vector<K>& vcs, vector<V>& vcout, vector<K>& vnxt, const SlpaMemory<K, C>& vcom, const vector<K>& vcur, const G& x, FR fr, FA fa, FP fp) {
+  K a = K(), b = K();
+  x.forEachVertexKey([&](auto u) {
+    vnxt[u] = vcur[u];
+    if (!fa(u)) { ++b; return; }
+    vnxt[u] = slpaScanChooseCommunity<STRICT>(vcs, vcout, x, u, vcom, fr);
+    if (vnxt[u]!=vcur[u]) { ++a; fp(u); }
+  });
+  return make_pair(a, b);
+}
+
+
+
+
+// SLPA-LISTEN-COMMUNITIES-PRUNE
+// -----------------------------
+
+/**
+ * Add community chosen by each processed vertex in this iteration to its
+ * memory, and find vertices to process in the next iteration (when pruning).
+ * Skipped vertices do not listen, and keep their memory as is.
+ * A processed vertex stays active if the label it listened to is not its
+ * community, and neighbors of vertices whose community has changed become
+ * active.
+ * @param vcom community set each vertex belongs to (updated)
+ * @param vcur latest community each vertex listened to (updated)
+ * @param vact is vertex active? (updated)
+ * @param vnew scratch flags (updated)
+ * @param vbst community each vertex belongs to (updated)
+ * @param vnxt community chosen by each vertex in this iteration
+ * @param x original graph
  */
-template <bool STRICT=false, class G, class K, class V, size_t L, class FR, class FA, class FP>
-K slpaMoveIteration(vector<K>& vcs, vector<V>& vcout, vector<Labelset<K, L>>& vcom, const G& x, K l, FR fr, FA fa, FP fp) {
-  K a = K();
+template <class G, class K, class C>
+inline void slpaListenCommunitiesPrune(SlpaMemory<K, C>& vcom, vector<K>& vcur, vector<char>& vact, vector<char>& vnew, vector<K>& vbst, const vector<K>& vnxt, const G& x) {
+  fillValueU(vnew, char());
   x.forEachVertexKey([&](auto u) {
-    if (!fa(u)) return;
-    slpaClearScan(vcs, vcout);
-    slpaScanCommunities(vcs, vcout, x, u, vcom, l, fr);
-    vcom[u][l] = slpaChooseCommunity<STRICT>(vcs, vcout);
-    if (vcom[u][l]!=vcom[u][l-1]) { ++a; fp(u); }
+    if (!vact[u]) return;
+    vcom.listen(u, vnxt[u]);
+    vcur[u] = vnxt[u];
+    K c = vcom.best(u);
+    if (c!=vcur[u]) vnew[u] = true;
+    if (c==vbst[u]) return;
+    vbst[u] = c;
+    x.forEachEdgeKey(u, [&](auto v) { vnew[v] = true; });
   });
-  return a;
+  swap(vact, vnew);
 }
 
 
@@ -51,40 +93,62 @@ K slpaMoveIteration(vector<K>& vcs, vector<V>& vcout, vector<Labelset<K, L>>& vc
 // SLPA-SEQ
 // --------
 
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K, class FA, class FP>
+// With PRUNE, only active vertices are processed in each iteration. All
+// vertices start active. A vertex is settled (inactive) once the label it
+// listened to is its community (most frequent label in memory), until
+// the community of a neighbor changes. The label chosen in each iteration
+// is random, and changes too often to be a useful signal by itself.
+// Skipped vertices do not listen (their memory is unchanged), as
+// recording their community again makes their memory over-concentrated.
+// Convergence is measured over processed vertices.
+
+template <bool STRICT=false, bool PRUNE=false, class G, class K, class FA, class FP>
 SlpaResult<K> slpaSeq(const G& x, const vector<K>* q, const SlpaOptions& o, FA fa, FP fp) {
   using V = typename G::edge_value_type;
-  const size_t L = LABELS;
   int l = 0;
+  size_t s = 0;
+  vector<SlpaIterationStats> stats;
   K S = x.span();
   K N = x.order();
   vector<K> vcs;
   vector<V> vcout(S);
-  vector<Labelset<K, L>> vcom(S);
+  vector<K> vcur(S), vnxt(S);
+  vector<K> vbst(PRUNE? S : 0);
+  vector<char> vact(PRUNE? S : 0), vnew(PRUNE? S : 0);
+  SlpaMemory<K> vcom(S, min(o.slots, o.labels));
   random_device dev;
   xorshift32_engine rnd(dev());
   auto fr = [&]() { return rnd(); };
+  auto fb = [&](auto u) { return fa(u) && (!PRUNE || vact[u]); };
   float t = measureDuration([&]() {
-    if (q) slpaInitializeFrom(vcom, x, *q);
-    else   slpaInitialize(vcom, x);
-    for (l=0; l < min(o.maxIterations, K(LABELS-1));) {
-      K n = slpaMoveIteration<STRICT>(vcs, vcout, vcom, x, ++l, fr, fa, fp);
-      PRINTFD("slpaSeq(): l=%d, n=%d, N=%d, n/N=%f\n", l, n, N, float(n)/N);
-      if (float(n)/N <= o.tolerance) break;
+    if (q) slpaInitializeFrom(vcom, vcur, x, *q);
+    else   slpaInitialize(vcom, vcur, x);
+    if (PRUNE) { fillValueU(vact, char(true)); copyValuesW(vbst, vcur); }
+    stats.clear();
+    for (l=0, s=0; l < min(o.maxIterations, o.labels-1);) {
+      auto t0 = timeNow();
+      if (o.counters) o.counters->start();
+      auto [n, m] = slpaMoveIteration<STRICT>(vcs, vcout, vnxt, vcom, vcur, x, fr, fb, fp); ++l; s += m;
+      PerfSample c = o.counters? o.counters->stop() : PerfSample();
+      if (PRUNE) slpaListenCommunitiesPrune(vcom, vcur, vact, vnew, vbst, vnxt, x);
+      else slpaListenCommunities(vcom, vcur, vnxt, x);
+      stats.push_back({durationMilliseconds(t0, timeNow()), size_t(n), size_t(m), c});
+      PRINTFD("slpaSeq(): l=%d, n=%d, N=%d, n/N=%f, skipped=%d\n", l, n, N, float(n)/N, m);
+      // Converged if few vertices have changed (of the processed ones, when pruning).
+      if (float(n)/(PRUNE? max(N-m, K(1)) : N) <= o.tolerance) break;
     } ++l;
   }, o.repeat);
-  slpaSortCommunities(vcom, l);
-  return {slpaBestCommunities(vcom, l), l, t};
+  return {slpaBestCommunities(vcom, S), l, t, s, move(stats)};
 }
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K, class FA>
+template <bool STRICT=false, bool PRUNE=false, class G, class K, class FA>
 inline SlpaResult<K> slpaSeq(const G& x, const vector<K>* q, const SlpaOptions& o, FA fa) {
   auto fp = [](auto u) {};
-  return slpaSeq<LABELS, STRICT>(x, q, o, fa, fp);
+  return slpaSeq<STRICT, PRUNE>(x, q, o, fa, fp);
 }
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K>
+template <bool STRICT=false, bool PRUNE=false, class G, class K>
 inline SlpaResult<K> slpaSeq(const G& x, const vector<K>* q, const SlpaOptions& o) {
   auto fa = [](auto u) { return true; };
-  return slpaSeq<LABELS, STRICT>(x, q, o, fa);
+  return slpaSeq<STRICT, PRUNE>(x, q, o, fa);
 }
 
 
@@ -93,9 +157,9 @@ inline SlpaResult<K> slpaSeq(const G& x, const vector<K>* q, const SlpaOptions&
 // SLPA-SEQ-STATIC
 // ---------------
 
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K>
+template <bool STRICT=false, bool PRUNE=false, class G, class K>
 inline SlpaResult<K> slpaSeqStatic(const G& x, const vector<K>* q=nullptr, const SlpaOptions& o={}) {
-  return slpaSeq<LABELS, STRICT>(x, q, o);
+  return slpaSeq<STRICT, PRUNE>(x, q, o);
 }
 
 
@@ -104,13 +168,11 @@ inline SlpaResult<K> slpaSeqStatic(const G& x, const vector<K>* q=nullptr, const
 // SLPA-SEQ-DYNAMIC-DELTA-SCREENING
 // --------------------------------
 
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K, class V>
+template <bool STRICT=false, class G, class K, class V>
 inline SlpaResult<K> slpaSeqDynamicDeltaScreening(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const SlpaOptions& o={}) {
-  const size_t L = LABELS;
-  K S = x.span();
   auto vaff = slpaAffectedVerticesDeltaScreening<STRICT>(x, deletions, insertions, *q);
   auto fa   = [&](auto u) { return vaff[u]==true; };
-  return slpaSeq<LABELS, STRICT>(x, q, o, fa);
+  return slpaSeq<STRICT>(x, q, o, fa);
 }
 
 
@@ -119,12 +181,10 @@ inline SlpaResult<K> slpaSeqDynamicDeltaScreening(const G& x, const vector<tuple
 // SLPA-SEQ-DYNAMIC-FRONTIER
 // -------------------------
 
-template <size_t LABELS=SLPA_MEMORY, bool STRICT=false, class G, class K, class V>
+template <bool STRICT=false, class G, class K, class V>
 inline SlpaResult<K> slpaSeqDynamicFrontier(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const SlpaOptions& o={}) {
-  const size_t L = LABELS;
-  K S = x.span();
   auto vaff = slpaAffectedVerticesFrontier(x, deletions, insertions, *q);
   auto fa = [&](auto u) { return vaff[u]==true; };
   auto fp = [&](auto u) { x.forEachEdgeKey(u, [&](auto v) { vaff[v] = true; }); };
-  return slpaSeq<LABELS, STRICT>(x, q, o, fa, fp);
+  return slpaSeq<STRICT>(x, q, o, fa, fp);
 }
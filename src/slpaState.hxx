@@ -0,0 +1,184 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "_main.hxx"
+#include "slpa.hxx"
+#include "slpaSeq.hxx"
+
+using std::tuple;
+using std::vector;
+using std::random_device;
+using std::swap;
+using std::min;
+
+
+
+
+// SLPA-STATE
+// ----------
+// Persistent SLPA state for a graph receiving a stream of edge batches.
+// Label memory, latest labels, random number generator, and scratch
+// buffers are kept across calls. Upon a batch update, only the affected
+// vertices (frontier approach) listen again, and continue from their
+// existing label memory (vertices that do not listen keep their memory
+// as is). Affected vertices are tracked with worklists, so the work done
+// per batch depends on the affected region, and not on the graph size.
+
+template <class K, class V=float, class C=uint16_t>
+class SlpaState {
+  // Data.
+  protected:
+  SlpaOptions      options;
+  SlpaMemory<K, C> vcom;   // label memory of each vertex
+  vector<K> vcur, vnxt;    // latest/chosen label of each vertex
+  vector<K> vbest;         // community each vertex belongs to
+  vector<K> vcs;           // communities vertex u is linked to
+  vector<V> vcout;         // total edge weight from vertex u to community C
+  vector<char> vaff;       // is vertex in next frontier?
+  vector<K> us, vs;        // current, next frontier
+  vector<K> vadd;          // vertices absent before this batch
+  xorshift32_engine rnd;
+
+
+  // Access operations.
+  public:
+  inline const vector<K>& membership() const noexcept { return vbest; }
+  inline K span() const noexcept { return K(vbest.size()); }
+
+
+  // Update operations.
+  public:
+  /**
+   * Run SLPA on the whole graph, discarding any existing state.
+   * @param x original graph
+   * @param q initial community each vertex belongs to (optional)
+   * @returns static SLPA result
+   */
+  template <bool STRICT=false, class G>
+  SlpaResult<K> initialize(const G& x, const vector<K>* q=nullptr) {
+    const SlpaOptions& o = options;
+    int l = 0;
+    K N = x.order();
+    auto fr = [&]() { return rnd(); };
+    auto fa = [](auto u) { return true; };
+    auto fp = [](auto u) {};
+    float t = measureDuration([&]() {
+      resize(x.span(), true);
+      if (q) slpaInitializeFrom(vcom, vcur, x, *q);
+      else   slpaInitialize(vcom, vcur, x);
+      for (l=0; l < min(o.maxIterations, o.labels-1);) {
+        K n = slpaMoveIteration<STRICT>(vcs, vcout, vnxt, vcom, vcur, x, fr, fa, fp).first; ++l;
+        slpaListenCommunities(vcom, vcur, vnxt, x);
+        PRINTFD("SlpaState::initialize(): l=%d, n=%d, N=%d, n/N=%f\n", l, n, N, float(n)/N);
+        if (float(n)/N <= o.tolerance) break;
+      } ++l;
+      x.forEachVertexKey([&](auto u) { vbest[u] = vcom.best(u); });
+    });
+    return {vector<K>(vbest), l, t};
+  }
+
+
+  /**
+   * Apply a batch of edge deletions and insertions to the graph, and
+   * update communities by letting affected vertices listen again.
+   * @param x original graph (updated)
+   * @param deletions edge deletions for this batch update (undirected, sorted by source vertex id)
+   * @param insertions edge insertions for this batch update (undirected, sorted by source vertex id)
+   * @returns dynamic SLPA result (time includes graph update)
+   */
+  template <bool STRICT=false, class G>
+  SlpaResult<K> update(G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions) {
+    const SlpaOptions& o = options;
+    int l = 0;
+    auto fr = [&]() { return rnd(); };
+    auto fm = [&](auto u) { if (!vaff[u]) { vaff[u] = true; vs.push_back(u); } };
+    float t = measureDuration([&]() {
+      K R = span();
+      // Only insertions can add vertices, at any id (not just beyond span).
+      vadd.clear();
+      for (const auto& [u, v, w] : insertions) {
+        if (!x.hasVertex(u)) vadd.push_back(u);
+        if (!x.hasVertex(v)) vadd.push_back(v);
+      }
+      for (const auto& [u, v] : deletions)
+        x.removeEdge(u, v);
+      for (const auto& [u, v, w] : insertions)
+        x.addEdge(u, v, w);
+      x.correct();
+      // New vertices start in their own community, and are affected.
+      vs.clear();
+      resize(x.span(), false);
+      for (K u : vadd) {
+        if (!x.hasVertex(u) || vaff[u]) continue;
+        vcom.reset(u, u);
+        vcur[u] = vbest[u] = u;
+        fm(u);
+      }
+      // Mark affected vertices, using communities before this batch.
+      for (const auto& [u, v] : deletions)
+        if (u<R && v<R && vbest[u]==vbest[v]) fm(u);
+      for (const auto& [u, v, w] : insertions)
+        if (u<R && v<R && vbest[u]!=vbest[v]) fm(u);
+      for (l=0; !vs.empty() && l < min(o.maxIterations, o.labels-1);) {
+        swap(us, vs); vs.clear();
+        K n = K(), N = K(us.size());
+        for (K u : us) {
+          vaff[u] = false;
+          vnxt[u] = slpaScanChooseCommunity<STRICT>(vcs, vcout, x, u, vcom, fr);
+        }
+        // Listen after all choices are made, as in the static algorithm.
+        // Neighbors are affected only if the community of a vertex changes,
+        // as the label spoken in each iteration is random.
+        for (K u : us) {
+          vcom.listen(u, vnxt[u]);
+          vcur[u] = vnxt[u];
+          K c = vcom.best(u);
+          if (c==vbest[u]) continue;
+          vbest[u] = c; ++n;
+          x.forEachEdgeKey(u, fm);
+        }
+        ++l;
+        PRINTFD("SlpaState::update(): l=%d, n=%d, N=%d, n/N=%f\n", l, n, N, float(n)/N);
+        if (float(n)/N <= o.tolerance) break;
+      }
+      for (K u : vs)
+        vaff[u] = false;
+      vs.clear();
+    });
+    return {vector<K>(vbest), l, t};
+  }
+
+
+  // Lifetime operations.
+  public:
+  /**
+   * Create empty SLPA state.
+   * @param o slpa options
+   */
+  SlpaState(const SlpaOptions& o={}) :
+  options(o), vcom(0, min(o.slots, o.labels)), rnd(o.seed? o.seed : random_device()()) {}
+
+
+  // Helper operations.
+  protected:
+  /**
+   * Change span of per-vertex data.
+   * @param S new span of graph
+   * @param clear discard existing data?
+   */
+  inline void resize(K S, bool clear) {
+    if (clear) *this = SlpaState(options, rnd);
+    vcom.resize(S);
+    vcur.resize(S);
+    vnxt.resize(S);
+    vbest.resize(S);
+    vcout.resize(S);
+    vaff.resize(S);
+  }
+
+  SlpaState(const SlpaOptions& o, const xorshift32_engine& rnd) :
+  options(o), vcom(0, min(o.slots, o.labels)), rnd(rnd) {}
+};
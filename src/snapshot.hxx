@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+#include "_main.hxx"
+#include "Graph.hxx"
+
+using std::vector;
+using std::move;
+
+
+
+
+// CSR-SNAPSHOT
+// ------------
+// Binary snapshot of a CSR graph (without vertex values), laid out as:
+// header, vertex exists flags (1 byte each), offsets, edge keys, edge values.
+// The header records size and modification time of the source file (if
+// given), so that a stale snapshot of another graph is not loaded.
+
+#define CSR_SNAPSHOT_MAGIC   "SLPACSR"
+#define CSR_SNAPSHOT_VERSION 2
+
+
+struct CsrSnapshotHeader {
+  char     magic[8];
+  uint32_t version;
+  uint8_t  keyBytes;
+  uint8_t  offsetBytes;
+  uint8_t  edgeValueBytes;
+  uint8_t  weighted;
+  uint64_t span;
+  uint64_t size;
+  uint64_t sourceSize;
+  int64_t  sourceTime;
+};
+
+
+/**
+ * Get size and modification time of a source file.
+ * @param pth path of file (or null)
+ * @param size file size (updated)
+ * @param time modification time, in nanoseconds (updated)
+ * @returns whether file exists
+ */
+inline bool csrSnapshotSource(const char *pth, uint64_t& size, int64_t& time) {
+  struct stat st;
+  size = 0; time = 0;
+  if (!pth || stat(pth, &st)<0) return false;
+  size = st.st_size;
+  time = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+
+
+
+// WRITE-CSR-SNAPSHOT
+// ------------------
+
+/**
+ * Write a binary snapshot of a CSR graph.
+ * @param pth path of file
+ * @param x CSR graph
+ * @param src path of source file the graph was read from (optional)
+ * @returns whether snapshot was written
+ */
+template <class K, class E, class O>
+bool writeCsrSnapshot(const char *pth, const CsrGraph<K, NONE, E, O>& x, const char *src=nullptr) {
+  const auto& vexists = x.csrVertexExists();
+  const auto& offsets = x.csrOffsets();
+  const auto& ekeys   = x.csrEdgeKeys();
+  const auto& evalues = x.csrEdgeValues();
+  CsrSnapshotHeader h = {};
+  memcpy(h.magic, CSR_SNAPSHOT_MAGIC, sizeof(CSR_SNAPSHOT_MAGIC));
+  h.version  = CSR_SNAPSHOT_VERSION;
+  h.keyBytes = sizeof(K);
+  h.offsetBytes    = sizeof(O);
+  h.edgeValueBytes = sizeof(E);
+  h.weighted = x.weighted();
+  h.span     = x.span();
+  h.size     = x.size();
+  csrSnapshotSource(src, h.sourceSize, h.sourceTime);
+  vector<uint8_t> vflags(vexists.begin(), vexists.end());
+  FILE *f = fopen(pth, "wb");
+  if (!f) return false;
+  bool a = fwrite(&h, sizeof(h), 1, f)==1;
+  a = a && fwrite(vflags.data(),  1, vflags.size(), f)==vflags.size();
+  a = a && fwrite(offsets.data(), sizeof(O), offsets.size(), f)==offsets.size();
+  a = a && fwrite(ekeys.data(),   sizeof(K), ekeys.size(), f)==ekeys.size();
+  a = a && fwrite(evalues.data(), sizeof(E), evalues.size(), f)==evalues.size();
+  return (fclose(f)==0) && a;
+}
+
+
+
+
+// READ-CSR-SNAPSHOT
+// -----------------
+
+/**
+ * Read a binary snapshot of a CSR graph.
+ * @param a CSR graph (updated only on success)
+ * @param pth path of file
+ * @param src path of source file the graph was read from (optional)
+ * @returns whether snapshot was read (false if missing, corrupt, of another version/type, or of another source)
+ */
+template <class K, class E, class O>
+bool readCsrSnapshotW(CsrGraph<K, NONE, E, O>& a, const char *pth, const char *src=nullptr) {
+  FILE *f = fopen(pth, "rb");
+  if (!f) return false;
+  CsrSnapshotHeader h;
+  bool ok = fread(&h, sizeof(h), 1, f)==1;
+  ok = ok && memcmp(h.magic, CSR_SNAPSHOT_MAGIC, sizeof(CSR_SNAPSHOT_MAGIC))==0;
+  ok = ok && h.version==CSR_SNAPSHOT_VERSION;
+  ok = ok && h.keyBytes==sizeof(K) && h.offsetBytes==sizeof(O) && h.edgeValueBytes==sizeof(E);
+  if (ok && src) {
+    uint64_t size; int64_t time;
+    ok = csrSnapshotSource(src, size, time) && h.sourceSize==size && h.sourceTime==time;
+  }
+  // Header must describe exactly the data in the file, before allocating
+  // (bounding span and size first, so that the expected size cannot overflow).
+  struct stat st;
+  ok = ok && fstat(fileno(f), &st)==0;
+  size_t FS = ok? size_t(st.st_size) : 0;
+  ok = ok && h.span<=FS && h.size<=FS;
+  ok = ok && FS == sizeof(h) + h.span + (h.span+1)*sizeof(O) + h.size*sizeof(K) + (h.weighted? h.size*sizeof(E) : 0);
+  if (!ok) { fclose(f); return false; }
+  size_t S = h.span, M = h.size;
+  vector<uint8_t> vflags(S);
+  vector<O> offsets(S+1);
+  vector<K> ekeys(M);
+  vector<E> evalues(h.weighted? M : 0);
+  ok = ok && fread(vflags.data(),  1, S, f)==S;
+  ok = ok && fread(offsets.data(), sizeof(O), S+1, f)==S+1;
+  ok = ok && fread(ekeys.data(),   sizeof(K), M, f)==M;
+  ok = ok && fread(evalues.data(), sizeof(E), evalues.size(), f)==evalues.size();
+  fclose(f);
+  if (!ok) return false;
+  // Offsets must be monotone and cover all edges, and keys must be vertices.
+  ok = offsets[0]==O() && size_t(offsets[S])==M;
+  for (size_t u=0; ok && u<S; ++u)
+    ok = offsets[u] <= offsets[u+1];
+  for (size_t i=0; ok && i<M; ++i)
+    ok = size_t(ekeys[i]) < S;
+  if (!ok) return false;
+  vector<bool> vexists(vflags.begin(), vflags.end());
+  a = CsrGraph<K, NONE, E, O>(move(vexists), vector<NONE>(S), move(offsets), move(ekeys), move(evalues));
+  return true;
+}